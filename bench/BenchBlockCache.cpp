@@ -0,0 +1,134 @@
+// Several threads, each with its own reader, reading random entries from the same hot region of one file
+// Separate BinaryReaderFile instances each go to the kernel for every entry; readers opened through a pool
+//   with a BlockCache, or BinaryReaderFile instances given one, share the blocks any of them has already loaded
+// Build: g++ -std=c++20 -O2 -Iinclude bench/BenchBlockCache.cpp -o BenchBlockCache -pthread
+// Usage: BenchBlockCache [dir] [hotMiB] [entriesPerThread]
+
+#include "BinaryReaderFile.h"
+#include "BinaryReaderSegmented.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr size_t FILE_SIZE = 64 * 1024 * 1024;
+	constexpr size_t MAX_ENTRY = 4096;
+
+	volatile uint64_t g_sink = 0;
+
+	// Runs body(thread) on `threads` threads at once and returns the wall time in ns
+	double
+	runThreads(size_t threads, const std::function<uint64_t(size_t)>& body)
+	{
+		std::vector<std::thread> workers;
+		std::vector<uint64_t> sums(threads);
+		auto start = std::chrono::steady_clock::now();
+		for (size_t t = 0; t < threads; t++)
+			workers.emplace_back([&, t] { sums[t] = body(t); });
+		for (auto& worker : workers)
+			worker.join();
+		auto end = std::chrono::steady_clock::now();
+		for (uint64_t sum : sums)
+			g_sink = g_sink + sum;
+		return std::chrono::duration<double, std::nano>(end - start).count();
+	}
+
+	// Random entries of 64 bytes to 4 KiB inside the first `hotSize` bytes
+	uint64_t
+	readEntries(BinaryReader::BinaryReader& reader, size_t hotSize, size_t entries, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<uint32_t> buf(MAX_ENTRY / sizeof(uint32_t));
+		uint64_t sum = 0;
+		for (size_t i = 0; i < entries; i++)
+		{
+			size_t count = 16 + rng() % (buf.size() - 16);
+			size_t offset = rng() % (hotSize - MAX_ENTRY) & ~(size_t)3;
+			reader.seek(offset, std::ios::beg);
+			reader.readScalarArray(buf.data(), count);
+			sum += buf[0] + buf[count - 1];
+		}
+		return sum;
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	std::string dir = argc > 1 ? argv[1] : "/tmp";
+	size_t hotSize = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16) * 1024 * 1024;
+	size_t entries = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 50000;
+	hotSize = std::min(std::max(hotSize, 2 * MAX_ENTRY), FILE_SIZE);
+
+	std::string path = dir + "/binaryreader_bench_blockcache.bin";
+	{
+		std::mt19937 rng(1234);
+		std::vector<uint8_t> data(FILE_SIZE);
+		for (auto& b : data)
+			b = (uint8_t)rng();
+		FILE* f = std::fopen(path.c_str(), "wb");
+		if (f == nullptr)
+		{
+			std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+			return 1;
+		}
+		std::fwrite(data.data(), 1, data.size(), f);
+		std::fclose(f);
+	}
+
+	std::printf("%zu MiB hot region, %zu entries per thread, %u hardware threads\n",
+		hotSize / (1024 * 1024), entries, std::thread::hardware_concurrency());
+	for (size_t threads : { 1, 2, 4, 8 })
+	{
+		double ns = runThreads(threads, [&](size_t t) {
+			BinaryReader::BinaryReaderFile reader(path);
+			return readEntries(reader, hotSize, entries, (uint32_t)t);
+		});
+		std::printf("%zu threads  BinaryReaderFile           %8.1f ns/entry\n", threads, ns / (entries * threads));
+
+		// Budget covers the hot region, so after warm-up every entry is a hit
+		BinaryReader::BlockCache cache(hotSize + hotSize / 4);
+		BinaryReader::FileHandlePool pool(BinaryReader::FileHandlePool::DEFAULT_CAPACITY, &cache);
+		ns = runThreads(threads, [&](size_t t) {
+			BinaryReader::BinaryReaderSegmented reader = pool.open(path);
+			return readEntries(reader, hotSize, entries, (uint32_t)t);
+		});
+		BinaryReader::BlockCacheStats stats = cache.stats();
+		std::printf("%zu threads  Segmented + BlockCache     %8.1f ns/entry  (%.1f%% hits, %llu evictions)\n",
+			threads, ns / (entries * threads), 100.0 * stats.hits / std::max<uint64_t>(stats.hits + stats.misses, 1),
+			(unsigned long long)stats.evictions);
+
+		BinaryReader::BlockCache fileCache(hotSize + hotSize / 4);
+		ns = runThreads(threads, [&](size_t t) {
+			BinaryReader::BinaryReaderFile reader(path, &fileCache);
+			return readEntries(reader, hotSize, entries, (uint32_t)t);
+		});
+		stats = fileCache.stats();
+		std::printf("%zu threads  BinaryReaderFile + cache   %8.1f ns/entry  (%.1f%% hits, %llu evictions)\n",
+			threads, ns / (entries * threads), 100.0 * stats.hits / std::max<uint64_t>(stats.hits + stats.misses, 1),
+			(unsigned long long)stats.evictions);
+
+		// Same, with a budget of a quarter of the hot region, so CLOCK has to make room
+		BinaryReader::BlockCache small(hotSize / 4);
+		BinaryReader::FileHandlePool smallPool(BinaryReader::FileHandlePool::DEFAULT_CAPACITY, &small);
+		ns = runThreads(threads, [&](size_t t) {
+			BinaryReader::BinaryReaderSegmented reader = smallPool.open(path);
+			return readEntries(reader, hotSize, entries, (uint32_t)t);
+		});
+		stats = small.stats();
+		std::printf("%zu threads  Segmented + 1/4 BlockCache %8.1f ns/entry  (%.1f%% hits, %llu evictions)\n",
+			threads, ns / (entries * threads), 100.0 * stats.hits / std::max<uint64_t>(stats.hits + stats.misses, 1),
+			(unsigned long long)stats.evictions);
+	}
+
+	std::remove(path.c_str());
+	return 0;
+}
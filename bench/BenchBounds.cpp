@@ -0,0 +1,113 @@
+// Cost of bounds checking on a fixed-size record decoded field by field
+// Per field: every read checked. Per record: one record() check, then unchecked reads from the returned slice
+// Built twice: BenchBounds as is, BenchBoundsChecked with BINARYREADER_BOUNDS_CHECK, which changes the virtual Slice
+// Build: g++ -std=c++20 -O2 -Iinclude [-DBINARYREADER_BOUNDS_CHECK] bench/BenchBounds.cpp -o BenchBounds
+
+#include "BinaryReaderSlice.h"
+#include "BinaryReaderStaticSlice.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr size_t DATA_SIZE = 64 * 1024 * 1024;
+	// uint32 id, uint16 type, uint16 flags, uint64 offset, float scale, uint32 length
+	constexpr size_t RECORD_SIZE = 24;
+
+	template <typename Fn>
+	double
+	nsPerOp(size_t ops, Fn&& fn)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+	}
+
+	template <class Reader>
+	uint64_t
+	decodeFields(Reader& reader)
+	{
+		uint64_t sum = reader.template readScalar<uint32_t>();
+		sum += reader.template readScalar<uint16_t>();
+		sum += reader.template readScalar<uint16_t>();
+		sum += reader.template readScalar<uint64_t>();
+		sum += (uint64_t)reader.template readScalar<float>();
+		sum += reader.template readScalar<uint32_t>();
+		return sum;
+	}
+
+	template <class Reader>
+	uint64_t
+	perField(Reader& reader)
+	{
+		uint64_t sum = 0;
+		size_t count = reader.getLength() / RECORD_SIZE;
+		reader.seek(0, std::ios::beg);
+		for (size_t i = 0; i < count; i++)
+			sum += decodeFields(reader);
+		return sum;
+	}
+
+	template <class Reader>
+	uint64_t
+	perRecord(Reader& reader)
+	{
+		uint64_t sum = 0;
+		size_t count = reader.getLength() / RECORD_SIZE;
+		reader.seek(0, std::ios::beg);
+		for (size_t i = 0; i < count; i++)
+		{
+			BinaryReader::RecordSlice record = reader.record(RECORD_SIZE);
+			sum += decodeFields(record);
+		}
+		return sum;
+	}
+
+	// Keeps the compiler from seeing the dynamic type
+	[[gnu::noinline]] BinaryReader::BinaryReader&
+	opaque(BinaryReader::BinaryReaderSlice& reader)
+	{
+		return reader;
+	}
+
+	void
+	report(const char* name, double ns)
+	{
+		std::printf("%-34s %6.3f ns/record\n", name, ns);
+	}
+}
+
+int
+main()
+{
+	std::vector<uint8_t> data(DATA_SIZE);
+	std::mt19937 rng(1234);
+	for (auto& b : data)
+		b = (uint8_t)rng();
+	size_t records = DATA_SIZE / RECORD_SIZE;
+
+	std::printf("BINARYREADER_BOUNDS_CHECK is %s\n", BinaryReader::DEFAULT_BOUNDS == BinaryReader::Bounds::Checked ? "on" : "off");
+
+	volatile uint64_t sink = 0;
+	{
+		BinaryReader::BinaryReaderSlice reader(data.data(), data.size());
+		report("Slice, per field", nsPerOp(records, [&] { sink = sink + perField(opaque(reader)); }));
+		report("Slice, per record", nsPerOp(records, [&] { sink = sink + perRecord(opaque(reader)); }));
+	}
+	{
+		BinaryReader::BasicStaticSlice<BinaryReader::Bounds::Unchecked> reader(data.data(), data.size());
+		report("StaticSlice unchecked, per field", nsPerOp(records, [&] { sink = sink + perField(reader); }));
+	}
+	{
+		BinaryReader::BasicStaticSlice<BinaryReader::Bounds::Checked> reader(data.data(), data.size());
+		report("StaticSlice checked, per field", nsPerOp(records, [&] { sink = sink + perField(reader); }));
+		report("StaticSlice checked, per record", nsPerOp(records, [&] { sink = sink + perRecord(reader); }));
+	}
+
+	return 0;
+}
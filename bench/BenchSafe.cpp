@@ -0,0 +1,155 @@
+// Cost of the Safe reads' debug message, and of exceptions vs tryRead* results when values fail
+// "std::string message" builds the message on every call, like the old const std::string& signature did
+// The tryRead* rows need std::expected (C++23); CMake builds this target as C++23 when the compiler can
+// Usage: BenchSafe [MiB]
+
+#include "BinaryReaderStaticSlice.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t LIMIT = 0x80000000u;
+
+	template <typename Fn>
+	double
+	nsPerOp(size_t ops, Fn&& fn)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+	}
+
+	void
+	report(const char* name, double ns)
+	{
+		std::printf("%-40s %7.3f ns/op\n", name, ns);
+	}
+
+	// Every value passes
+	void
+	passing(const std::vector<uint8_t>& data)
+	{
+		volatile uint64_t sink = 0;
+		size_t ops = data.size() / sizeof(uint32_t);
+		std::string name = "chunk header";
+
+		auto run = [&](const char* label, auto&& readOne) {
+			BinaryReader::BinaryReaderStaticSlice reader(data.data(), data.size());
+			report(label, nsPerOp(ops, [&] {
+				uint64_t sum = 0;
+				for (size_t i = 0; i < ops; i++)
+					sum += readOne(reader);
+				sink = sink + sum;
+			}));
+		};
+
+		run("readScalarSafe, std::string message", [](auto& r) {
+			return r.template readScalarSafe<uint32_t>(0, LIMIT, std::string("Value out of range in chunk header"));
+		});
+		run("readScalarSafe, literal", [](auto& r) {
+			return r.template readScalarSafe<uint32_t>(0, LIMIT, "Value out of range in chunk header");
+		});
+		run("readScalarSafe, callable", [&](auto& r) {
+			return r.template readScalarSafe<uint32_t>(0, LIMIT, [&] { return "Value out of range in " + name; });
+		});
+#ifdef BINARYREADER_HAS_EXPECTED
+		run("tryReadScalar", [](auto& r) {
+			return *r.template tryReadScalar<uint32_t>(0, LIMIT);
+		});
+#endif
+
+		std::vector<uint32_t> buf(4096);
+		auto runArray = [&](const char* label, auto&& readChunk) {
+			BinaryReader::BinaryReaderStaticSlice reader(data.data(), data.size());
+			size_t chunks = ops / buf.size();
+			report(label, nsPerOp(chunks * buf.size(), [&] {
+				for (size_t i = 0; i < chunks; i++)
+					readChunk(reader);
+				sink = sink + buf[0];
+			}));
+		};
+
+		runArray("readScalarArraySafe, std::string message", [&](auto& r) {
+			r.template readScalarArraySafe<uint32_t>(buf.data(), buf.size(), 0, LIMIT, std::string("Value out of range in chunk header"));
+		});
+		runArray("readScalarArraySafe, literal", [&](auto& r) {
+			r.template readScalarArraySafe<uint32_t>(buf.data(), buf.size(), 0, LIMIT, "Value out of range in chunk header");
+		});
+#ifdef BINARYREADER_HAS_EXPECTED
+		runArray("tryReadScalarArray", [&](auto& r) {
+			(void)r.template tryReadScalarArray<uint32_t>(buf.data(), buf.size(), 0, LIMIT);
+		});
+#endif
+	}
+
+	// A validation loop over values where `failPercent` of them are out of range
+	void
+	failing(const std::vector<uint8_t>& data, unsigned failPercent)
+	{
+		volatile uint64_t sink = 0;
+		size_t ops = data.size() / sizeof(uint32_t);
+		uint32_t limit = (uint32_t)(0xFFFFFFFFull * (100 - failPercent) / 100);
+		char label[64];
+
+		{
+			BinaryReader::BinaryReaderStaticSlice reader(data.data(), data.size());
+			std::snprintf(label, sizeof(label), "%u%% failing, exceptions", failPercent);
+			report(label, nsPerOp(ops, [&] {
+				uint64_t failures = 0;
+				for (size_t i = 0; i < ops; i++)
+				{
+					try
+					{
+						reader.readScalarSafe<uint32_t>(0, limit, "Value out of range");
+					}
+					catch (const LimitException&)
+					{
+						failures++;
+					}
+				}
+				sink = sink + failures;
+			}));
+		}
+#ifdef BINARYREADER_HAS_EXPECTED
+		{
+			BinaryReader::BinaryReaderStaticSlice reader(data.data(), data.size());
+			std::snprintf(label, sizeof(label), "%u%% failing, tryReadScalar", failPercent);
+			report(label, nsPerOp(ops, [&] {
+				uint64_t failures = 0;
+				for (size_t i = 0; i < ops; i++)
+					failures += !reader.tryReadScalar<uint32_t>(0, limit).has_value();
+				sink = sink + failures;
+			}));
+		}
+#endif
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	size_t sizeMiB = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16;
+	std::vector<uint8_t> data(std::max<size_t>(sizeMiB, 1) * 1024 * 1024);
+	std::mt19937 rng(1234);
+	for (auto& b : data)
+		b = (uint8_t)rng();
+
+	// Top bit clear, so the passing runs never throw
+	std::vector<uint8_t> passingData = data;
+	for (size_t i = 3; i < passingData.size(); i += 4)
+		passingData[i] &= 0x7F;
+
+	passing(passingData);
+	failing(data, 1);
+	failing(data, 10);
+	return 0;
+}
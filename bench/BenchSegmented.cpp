@@ -0,0 +1,110 @@
+// Many small entry reads spread over an archive's part files
+// A new BinaryReaderFile per entry (ifstream + seek to end) vs FileHandlePool::open, which reuses descriptors
+// Build: g++ -std=c++20 -O2 -Iinclude bench/BenchSegmented.cpp -o BenchSegmented
+// Usage: BenchSegmented [dir] [parts] [entries]
+
+#include "BinaryReaderFile.h"
+#include "BinaryReaderSegmented.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr size_t PART_SIZE = 4 * 1024 * 1024;
+
+	struct Entry
+	{
+		size_t part;
+		size_t offset;
+		size_t length;
+	};
+
+	double
+	nsPerEntry(size_t entries, const std::function<uint64_t()>& fn)
+	{
+		static volatile uint64_t sink = 0;
+		auto start = std::chrono::steady_clock::now();
+		sink = sink + fn();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / entries;
+	}
+
+	// Every entry is a uint32 count followed by that many uint32s
+	uint64_t
+	decodeEntry(BinaryReader::BinaryReader& reader, std::vector<uint32_t>& buf)
+	{
+		uint32_t count = reader.readScalar<uint32_t>() % (uint32_t)buf.size();
+		reader.readScalarArray(buf.data(), count);
+		return count;
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	std::string dir = argc > 1 ? argv[1] : "/tmp";
+	size_t parts = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16;
+	size_t entries = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 50000;
+
+	std::mt19937 rng(1234);
+	std::vector<std::string> paths;
+	std::vector<uint8_t> data(PART_SIZE);
+	for (size_t i = 0; i < parts; i++)
+	{
+		for (auto& b : data)
+			b = (uint8_t)rng();
+		paths.push_back(dir + "/binaryreader_bench_part" + std::to_string(i) + ".cache");
+		FILE* f = std::fopen(paths.back().c_str(), "wb");
+		if (f == nullptr)
+		{
+			std::fprintf(stderr, "Cannot write %s\n", paths.back().c_str());
+			return 1;
+		}
+		std::fwrite(data.data(), 1, data.size(), f);
+		std::fclose(f);
+	}
+
+	std::vector<Entry> lookups(entries);
+	for (auto& entry : lookups)
+	{
+		entry.part = rng() % parts;
+		entry.length = 4 + 4 * 256;
+		entry.offset = rng() % (PART_SIZE - entry.length);
+	}
+
+	std::vector<uint32_t> buf(256);
+	double ns = nsPerEntry(entries, [&] {
+		uint64_t sum = 0;
+		for (const Entry& entry : lookups)
+		{
+			BinaryReader::BinaryReaderFile reader(paths[entry.part]);
+			reader.seek(entry.offset, std::ios::beg);
+			sum += decodeEntry(reader, buf);
+		}
+		return sum;
+	});
+	std::printf("BinaryReaderFile per entry     %9.1f ns/entry\n", ns);
+
+	BinaryReader::FileHandlePool pool;
+	ns = nsPerEntry(entries, [&] {
+		uint64_t sum = 0;
+		for (const Entry& entry : lookups)
+		{
+			BinaryReader::BinaryReaderSegmented reader = pool.open(paths[entry.part], entry.offset, entry.length);
+			sum += decodeEntry(reader, buf);
+		}
+		return sum;
+	});
+	std::printf("FileHandlePool::open           %9.1f ns/entry (%llu opens)\n", ns, (unsigned long long)pool.misses());
+
+	for (const std::string& path : paths)
+		std::remove(path.c_str());
+	return 0;
+}
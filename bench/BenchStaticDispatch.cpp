@@ -0,0 +1,122 @@
+// Per-scalar cost of virtual dispatch (BinaryReaderSlice) vs compile-time dispatch (BinaryReaderStaticSlice)
+// Build: g++ -std=c++20 -O2 -Iinclude bench/BenchStaticDispatch.cpp -o BenchStaticDispatch
+
+#include "BinaryReaderSlice.h"
+#include "BinaryReaderStaticSlice.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr size_t DATA_SIZE = 64 * 1024 * 1024;
+
+	template <typename Fn>
+	double
+	nsPerOp(size_t ops, Fn&& fn)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+	}
+
+	template <class Reader>
+	uint64_t
+	sumScalars(Reader& reader)
+	{
+		uint64_t sum = 0;
+		size_t count = reader.getLength() / sizeof(uint32_t);
+		for (size_t i = 0; i < count; i++)
+			sum += reader.template readScalar<uint32_t>();
+		return sum;
+	}
+
+	template <class Reader>
+	float
+	sumHalfs(Reader& reader)
+	{
+		float sum = 0;
+		size_t count = reader.getLength() / sizeof(uint16_t);
+		for (size_t i = 0; i < count; i++)
+			sum += reader.readHalf();
+		return sum;
+	}
+
+	template <class Reader>
+	uint64_t
+	sumULEBs(Reader& reader, size_t count)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < count; i++)
+			sum += reader.readULEB();
+		return sum;
+	}
+
+	// Keeps the compiler from seeing the dynamic type
+	[[gnu::noinline]] BinaryReader::BinaryReader&
+	opaque(BinaryReader::BinaryReaderSlice& reader)
+	{
+		return reader;
+	}
+
+	void
+	report(const char* name, double virtualNs, double staticNs)
+	{
+		std::printf("%-12s virtual %6.3f ns/op   static %6.3f ns/op   (%.2fx)\n", name, virtualNs, staticNs, virtualNs / staticNs);
+	}
+}
+
+int
+main()
+{
+	std::vector<uint8_t> data(DATA_SIZE);
+	std::mt19937 rng(1234);
+	for (auto& b : data)
+		b = (uint8_t)rng();
+
+	// ULEB stream of small values with an occasional multi-byte one
+	std::vector<uint8_t> lebData;
+	size_t lebCount = 0;
+	while (lebData.size() + 10 < DATA_SIZE)
+	{
+		uint64_t value = rng() % 16 == 0 ? rng() : rng() % 128;
+		do
+		{
+			uint8_t b = value & 0x7F;
+			value >>= 7;
+			lebData.push_back(b | (value ? 0x80 : 0));
+		} while (value);
+		lebCount++;
+	}
+
+	volatile uint64_t sink = 0;
+	{
+		BinaryReader::BinaryReaderSlice v(data.data(), data.size());
+		BinaryReader::BinaryReaderStaticSlice s(data.data(), data.size());
+		size_t ops = data.size() / sizeof(uint32_t);
+		double vNs = nsPerOp(ops, [&] { sink = sink + sumScalars(opaque(v)); });
+		double sNs = nsPerOp(ops, [&] { sink = sink + sumScalars(s); });
+		report("readScalar", vNs, sNs);
+	}
+	{
+		BinaryReader::BinaryReaderSlice v(data.data(), data.size());
+		BinaryReader::BinaryReaderStaticSlice s(data.data(), data.size());
+		size_t ops = data.size() / sizeof(uint16_t);
+		double vNs = nsPerOp(ops, [&] { sink = sink + (uint64_t)sumHalfs(opaque(v)); });
+		double sNs = nsPerOp(ops, [&] { sink = sink + (uint64_t)sumHalfs(s); });
+		report("readHalf", vNs, sNs);
+	}
+	{
+		BinaryReader::BinaryReaderSlice v(lebData.data(), lebData.size());
+		BinaryReader::BinaryReaderStaticSlice s(lebData.data(), lebData.size());
+		double vNs = nsPerOp(lebCount, [&] { sink = sink + sumULEBs(opaque(v), lebCount); });
+		double sNs = nsPerOp(lebCount, [&] { sink = sink + sumULEBs(s, lebCount); });
+		report("readULEB", vNs, sNs);
+	}
+
+	return 0;
+}
@@ -0,0 +1,139 @@
+// Many small arrays per file: std::vector per array vs readVector into a monotonic arena
+// Each "file" is a run of records, each a ULEB count followed by that many uint32s or ULEBs,
+//   and every decoded array is kept until the whole file is done, like a parser's output
+// Usage: BenchVector [records] [rounds]
+
+#include "BinaryReaderBuffered.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+namespace
+{
+	volatile uint64_t g_sink = 0;
+
+	double
+	nsPerRecord(size_t records, size_t rounds, const std::function<uint64_t()>& fn)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < rounds; i++)
+			g_sink = g_sink + fn();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / (records * rounds);
+	}
+
+	std::vector<uint8_t>
+	makeFile(size_t records, bool leb)
+	{
+		std::mt19937 rng(1234);
+		std::vector<uint8_t> data;
+		auto putULEB = [&](uint64_t value) {
+			do
+			{
+				uint8_t b = value & 0x7F;
+				value >>= 7;
+				data.push_back(b | (value ? 0x80 : 0));
+			} while (value);
+		};
+
+		for (size_t i = 0; i < records; i++)
+		{
+			// Mostly a handful of elements, sometimes a few hundred
+			size_t count = rng() % 8 == 0 ? rng() % 512 : rng() % 24;
+			putULEB(count);
+			for (size_t j = 0; j < count; j++)
+			{
+				uint32_t value = rng() % 1000;
+				if (leb)
+					putULEB(value);
+				else
+					data.insert(data.end(), (uint8_t*)&value, (uint8_t*)&value + sizeof(value));
+			}
+		}
+		return data;
+	}
+
+	uint64_t
+	stdVectors(BinaryReader::BinaryReader& reader, size_t records, bool leb)
+	{
+		reader.seek(0, std::ios::beg);
+		std::vector<std::vector<uint32_t>> scalars;
+		std::vector<std::vector<uint64_t>> lebs;
+		for (size_t i = 0; i < records; i++)
+		{
+			size_t count = reader.readULEB();
+			if (leb)
+			{
+				std::vector<uint64_t> values(count);
+				reader.readULEBArray(values.data(), count);
+				lebs.push_back(std::move(values));
+			}
+			else
+			{
+				std::vector<uint32_t> values(count);
+				reader.readScalarArray(values.data(), count);
+				scalars.push_back(std::move(values));
+			}
+		}
+		return scalars.size() + lebs.size();
+	}
+
+	// `resource` backs both the arrays and the list holding them; null means the default resource
+	uint64_t
+	pmrVectors(BinaryReader::BinaryReader& reader, size_t records, bool leb, std::pmr::monotonic_buffer_resource* arena)
+	{
+		std::pmr::memory_resource* resource = arena != nullptr ? arena : std::pmr::get_default_resource();
+		reader.seek(0, std::ios::beg);
+		uint64_t ret;
+		{
+			std::pmr::vector<std::pmr::vector<uint32_t>> scalars(resource);
+			std::pmr::vector<std::pmr::vector<uint64_t>> lebs(resource);
+			for (size_t i = 0; i < records; i++)
+			{
+				size_t count = reader.readULEB();
+				if (leb)
+					lebs.push_back(reader.readULEBVector(count, resource));
+				else
+					scalars.push_back(reader.readVector<uint32_t>(count, resource));
+			}
+			ret = scalars.size() + lebs.size();
+		}
+		if (arena != nullptr)
+			arena->release();
+		return ret;
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	size_t records = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+	size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10;
+
+	for (bool leb : { false, true })
+	{
+		std::vector<uint8_t> file = makeFile(records, leb);
+		size_t fileSize = file.size();
+		BinaryReader::BinaryReaderBuffered reader(std::move(file));
+		const char* pattern = leb ? "ULEB arrays" : "uint32 arrays";
+
+		double ns = nsPerRecord(records, rounds, [&] { return stdVectors(reader, records, leb); });
+		std::printf("%-14s std::vector                %7.2f ns/array\n", pattern, ns);
+
+		ns = nsPerRecord(records, rounds, [&] { return pmrVectors(reader, records, leb, nullptr); });
+		std::printf("%-14s readVector, default        %7.2f ns/array\n", pattern, ns);
+
+		// release() rewinds to the initial buffer, so rounds reuse it like a per-thread arena would
+		std::vector<std::byte> buffer(fileSize * 8 + records * 64);
+		std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+		ns = nsPerRecord(records, rounds, [&] { return pmrVectors(reader, records, leb, &arena); });
+		std::printf("%-14s readVector, monotonic      %7.2f ns/array\n", pattern, ns);
+	}
+	return 0;
+}
@@ -0,0 +1,97 @@
+// BinaryReaderFile (std::ifstream) vs BinaryReaderWindowed on common parse patterns
+// Build: g++ -std=c++20 -O2 -Iinclude bench/BenchWindowed.cpp -o BenchWindowed
+// Usage: BenchWindowed [path] [sizeMiB]
+
+#include "BinaryReaderFile.h"
+#include "BinaryReaderWindowed.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	double
+	nsPerOp(size_t ops, const std::function<void()>& fn)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+	}
+
+	// Straight run of little-endian scalars
+	uint64_t
+	sequential(BinaryReader::BinaryReader& reader, size_t ops)
+	{
+		uint64_t sum = 0;
+		reader.seek(0, std::ios::beg);
+		for (size_t i = 0; i < ops; i++)
+			sum += reader.readScalar<uint32_t>();
+		return sum;
+	}
+
+	// Read a small header, step back over part of it, continue
+	uint64_t
+	backwardSeeks(BinaryReader::BinaryReader& reader, size_t ops)
+	{
+		uint64_t sum = 0;
+		reader.seek(0, std::ios::beg);
+		for (size_t i = 0; i < ops; i++)
+		{
+			sum += reader.readScalar<uint32_t>();
+			sum += reader.readScalar<uint16_t>();
+			sum += reader.readScalar<uint16_t>();
+			reader.seek(-6, std::ios::cur);
+			sum += reader.readScalarBE<uint16_t>();
+		}
+		return sum;
+	}
+
+	void
+	run(const char* pattern, const std::string& path, size_t ops, uint64_t (*fn)(BinaryReader::BinaryReader&, size_t))
+	{
+		volatile uint64_t sink = 0;
+
+		BinaryReader::BinaryReaderFile file(path);
+		std::printf("%-16s BinaryReaderFile           %7.2f ns/op\n", pattern, nsPerOp(ops, [&] { sink = fn(file, ops); }));
+
+		for (size_t windowSize : { (size_t)64 * 1024, (size_t)1024 * 1024, (size_t)4 * 1024 * 1024 })
+		{
+			BinaryReader::BinaryReaderWindowed windowed(path, windowSize);
+			double ns = nsPerOp(ops, [&] { sink = fn(windowed, ops); });
+			std::printf("%-16s BinaryReaderWindowed %4zuK %7.2f ns/op\n", pattern, windowSize / 1024, ns);
+		}
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	std::string path = argc > 1 ? argv[1] : "bench_windowed.bin";
+	size_t sizeMiB = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+	size_t size = sizeMiB * 1024 * 1024;
+
+	{
+		std::vector<uint8_t> data(size);
+		std::mt19937 rng(1234);
+		for (auto& b : data)
+			b = (uint8_t)rng();
+		FILE* f = std::fopen(path.c_str(), "wb");
+		if (f == nullptr)
+			return 1;
+		std::fwrite(data.data(), 1, data.size(), f);
+		std::fclose(f);
+	}
+
+	run("sequential", path, size / sizeof(uint32_t), sequential);
+	run("backward-seek", path, (size - 16) / 4, backwardSeeks);
+
+	std::remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,552 @@
+// Throughput of every backend x read kind on synthetic data
+// Usage: BinaryReaderBench [--size MiB] [--budget seconds] [--filter text] [--json path] [--dir path]
+//   --filter keeps runs whose "backend/kind" name contains the text
+
+#include "BinaryReaderBuffered.h"
+#include "BinaryReaderDecompressed.h"
+#include "BinaryReaderFile.h"
+#include "BinaryReaderMapped.h"
+#include "BinaryReaderPrefetched.h"
+#include "BinaryReaderSegmented.h"
+#include "BinaryReaderSlice.h"
+#include "BinaryReaderStaticSlice.h"
+#include "BinaryReaderWindowed.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		size_t sizeMiB = 64;
+		double budget = 0.25;
+		std::string filter;
+		std::string jsonPath;
+		std::string dir = ".";
+	};
+
+	struct Result
+	{
+		std::string backend;
+		std::string kind;
+		size_t ops;
+		size_t bytes;
+		double seconds;
+	};
+
+	// Every byte is < 0x80, so 32-bit values stay below 0x80000000 in either byte order
+	//   and the Safe kinds never throw
+	constexpr uint32_t SAFE_MAX = 0x80000000u;
+	// Read as floats, the same bytes are positive with an even exponent below 255: zero, subnormal or finite, never inf or NaN
+	constexpr float FLOAT_SAFE_MAX = std::numeric_limits<float>::infinity();
+	constexpr size_t CHUNK = 16 * 1024;
+	constexpr int BIT_WIDTH = 13;
+
+	volatile uint64_t g_sink = 0;
+
+	//////////////////////////////////////////////////////////////////////////////
+	// Read kinds
+	// Each call performs `ops` operations from the current cursor and returns a checksum
+	// They are noinline so virtual backends are measured through real virtual calls
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindScalarLE(R& r, size_t ops)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < ops; i++)
+			sum += r.template readScalar<uint32_t>();
+		return sum;
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindScalarBE(R& r, size_t ops)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < ops; i++)
+			sum += r.template readScalarBE<uint32_t>();
+		return sum;
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindArrayLE(R& r, size_t ops)
+	{
+		static thread_local std::vector<uint32_t> buf(CHUNK);
+		r.template readScalarArray<uint32_t>(buf.data(), ops);
+		return buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindArrayBE(R& r, size_t ops)
+	{
+		static thread_local std::vector<uint32_t> buf(CHUNK);
+		r.template readScalarArrayBE<uint32_t>(buf.data(), ops);
+		return buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindArraySafe(R& r, size_t ops)
+	{
+		static thread_local std::vector<uint32_t> buf(CHUNK);
+		r.template readScalarArraySafe<uint32_t>(buf.data(), ops, 0u, SAFE_MAX, "bench");
+		return buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindArrayBESafe(R& r, size_t ops)
+	{
+		static thread_local std::vector<uint32_t> buf(CHUNK);
+		r.template readScalarArrayBESafe<uint32_t>(buf.data(), ops, 0u, SAFE_MAX, "bench");
+		return buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindFloatArraySafe(R& r, size_t ops)
+	{
+		static thread_local std::vector<float> buf(CHUNK);
+		r.template readScalarArraySafe<float>(buf.data(), ops, 0.0f, FLOAT_SAFE_MAX, 0, "bench");
+		return (uint64_t)buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindFloatArrayBESafe(R& r, size_t ops)
+	{
+		static thread_local std::vector<float> buf(CHUNK);
+		r.template readScalarArrayBESafe<float>(buf.data(), ops, 0.0f, FLOAT_SAFE_MAX, 0, "bench");
+		return (uint64_t)buf[0];
+	}
+
+	// Same, with the conversions applied as well
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindFloatArrayConv(R& r, size_t ops)
+	{
+		static thread_local std::vector<float> buf(CHUNK);
+		r.template readScalarArraySafe<float>(buf.data(), ops, 0.0f, FLOAT_SAFE_MAX, CONV_INF | CONV_ZERO, "bench");
+		return (uint64_t)buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindFloatArrayBEConv(R& r, size_t ops)
+	{
+		static thread_local std::vector<float> buf(CHUNK);
+		r.template readScalarArrayBESafe<float>(buf.data(), ops, 0.0f, FLOAT_SAFE_MAX, CONV_INF | CONV_ZERO, "bench");
+		return (uint64_t)buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindHalf(R& r, size_t ops)
+	{
+		float sum = 0;
+		for (size_t i = 0; i < ops; i++)
+			sum += r.readHalf();
+		return (uint64_t)sum;
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindHalfArray(R& r, size_t ops)
+	{
+		static thread_local std::vector<float> buf(CHUNK);
+		r.readHalfArray(buf.data(), ops);
+		return (uint64_t)buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindULEB(R& r, size_t ops)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < ops; i++)
+			sum += r.readULEB();
+		return sum;
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindULEBArray(R& r, size_t ops)
+	{
+		static thread_local std::vector<uint64_t> buf(CHUNK);
+		r.readULEBArray(buf.data(), ops);
+		return buf[0];
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindBitwise(R& r, size_t ops)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < ops; i++)
+			sum += r.template readBitwiseScalar<uint32_t>(BIT_WIDTH);
+		return sum;
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindBitwiseArray(R& r, size_t ops)
+	{
+		static thread_local std::vector<uint32_t> buf(CHUNK);
+		r.template readBitwiseArray<uint32_t>(BIT_WIDTH, ops, buf.data());
+		return buf[0];
+	}
+
+	// Random jumps anywhere in the file
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindSeekRandom(R& r, size_t ops)
+	{
+		static thread_local std::mt19937_64 rng(42);
+		size_t span = r.getLength() - sizeof(uint64_t);
+		size_t start = r.tell();
+		uint64_t sum = 0;
+		for (size_t i = 0; i < ops; i++)
+		{
+			r.seek(rng() % span, std::ios::beg);
+			sum += r.template readScalar<uint64_t>();
+		}
+		// Keep the harness's sequential accounting intact
+		r.seek(start + ops * sizeof(uint64_t), std::ios::beg);
+		return sum;
+	}
+
+	// Read a header, step back over part of it, continue
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindSeekBackward(R& r, size_t ops)
+	{
+		uint64_t sum = 0;
+		for (size_t i = 0; i < ops; i++)
+		{
+			sum += r.template readScalar<uint64_t>();
+			// Net advance is 4 bytes per op
+			r.seek(-6, std::ios::cur);
+			sum += r.template readScalar<uint16_t>();
+		}
+		return sum;
+	}
+
+	template <class R>
+	[[gnu::noinline]] uint64_t
+	kindReadAt(R& r, size_t ops)
+	{
+		static thread_local std::mt19937_64 rng(7);
+		size_t span = r.getLength() - sizeof(uint64_t);
+		uint64_t sum = 0;
+		for (size_t i = 0; i < ops; i++)
+			sum += r.template readAt<uint64_t>(rng() % span);
+		r.seek(ops * sizeof(uint64_t), std::ios::cur);
+		return sum;
+	}
+
+	template <class R>
+	struct Kind
+	{
+		const char* name;
+		// Bytes consumed from the stream per operation
+		size_t bytesPerOp;
+		// Largest op count per call, for kinds that read into a scratch buffer
+		size_t chunk;
+		bool leb;
+		uint64_t (*fn)(R&, size_t);
+	};
+
+	template <class R>
+	std::vector<Kind<R>>
+	kinds()
+	{
+		return {
+			{ "readScalar_le", 4, CHUNK, false, kindScalarLE<R> },
+			{ "readScalar_be", 4, CHUNK, false, kindScalarBE<R> },
+			{ "readScalarArray_le", 4, CHUNK, false, kindArrayLE<R> },
+			{ "readScalarArray_be", 4, CHUNK, false, kindArrayBE<R> },
+			{ "readScalarArraySafe_le", 4, CHUNK, false, kindArraySafe<R> },
+			{ "readScalarArraySafe_be", 4, CHUNK, false, kindArrayBESafe<R> },
+			{ "readFloatArraySafe_le", 4, CHUNK, false, kindFloatArraySafe<R> },
+			{ "readFloatArraySafe_be", 4, CHUNK, false, kindFloatArrayBESafe<R> },
+			{ "readFloatArrayConv_le", 4, CHUNK, false, kindFloatArrayConv<R> },
+			{ "readFloatArrayConv_be", 4, CHUNK, false, kindFloatArrayBEConv<R> },
+			{ "readHalf", 2, CHUNK, false, kindHalf<R> },
+			{ "readHalfArray", 2, CHUNK, false, kindHalfArray<R> },
+			{ "readULEB", 0, CHUNK, true, kindULEB<R> },
+			{ "readULEBArray", 0, CHUNK, true, kindULEBArray<R> },
+			{ "readBitwiseScalar", 2, CHUNK, false, kindBitwise<R> },
+			{ "readBitwiseArray", 2, CHUNK, false, kindBitwiseArray<R> },
+			{ "seek_random", 8, 1024, false, kindSeekRandom<R> },
+			{ "seek_backward", 4, CHUNK, false, kindSeekBackward<R> },
+			{ "readAt_random", 8, 1024, false, kindReadAt<R> },
+		};
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// Harness
+
+	bool
+	selected(const Options& opts, const std::string& name)
+	{
+		return opts.filter.empty() || name.find(opts.filter) != std::string::npos;
+	}
+
+	// Runs one kind until the data runs out or the time budget is spent
+	template <class R>
+	Result
+	measure(const std::string& backend, const Kind<R>& kind, R& reader, size_t lebValueCount, const Options& opts)
+	{
+		reader.seek(0, std::ios::beg);
+		reader.seekBit(0, std::ios::beg);
+
+		// ULEB kinds count values instead of fixed-size elements
+		size_t totalOps = kind.leb ? lebValueCount : (reader.getLength() - 16) / kind.bytesPerOp;
+		// Bitwise kinds consume 13 bits per op, not 2 bytes
+		if (kind.fn == kindBitwise<R> || kind.fn == kindBitwiseArray<R>)
+			totalOps = (reader.getLength() - 16) * 8 / BIT_WIDTH;
+
+		size_t ops = 0;
+		auto start = std::chrono::steady_clock::now();
+		double elapsed = 0;
+		while (ops < totalOps && elapsed < opts.budget)
+		{
+			size_t n = std::min(kind.chunk, totalOps - ops);
+			g_sink = g_sink + kind.fn(reader, n);
+			ops += n;
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		size_t bytes = kind.leb ? reader.tell() : (kind.bytesPerOp * ops);
+		if (kind.fn == kindBitwise<R> || kind.fn == kindBitwiseArray<R>)
+			bytes = ops * BIT_WIDTH / 8;
+		return { backend, kind.name, ops, bytes, elapsed };
+	}
+
+	template <class R>
+	void
+	runBackend(const std::string& backend, R& data, R& leb, size_t lebValueCount, const Options& opts, std::vector<Result>& results)
+	{
+		for (const auto& kind : kinds<R>())
+		{
+			std::string name = backend + "/" + kind.name;
+			if (!selected(opts, name))
+				continue;
+
+			Result result;
+			try
+			{
+				result = measure(backend, kind, kind.leb ? leb : data, lebValueCount, opts);
+			}
+			catch (const std::logic_error&)
+			{
+				// Backend doesn't support this kind (positional reads)
+				std::printf("%-14s %-24s %16s\n", backend.c_str(), kind.name, "unsupported");
+				continue;
+			}
+			results.push_back(result);
+			std::printf("%-14s %-24s %10.3f ns/op %9.3f GB/s\n", backend.c_str(), kind.name,
+				result.seconds * 1e9 / result.ops, result.bytes / result.seconds / 1e9);
+			std::fflush(stdout);
+		}
+	}
+
+	// Each backend is built from a file path. The virtual ones run through BinaryReader&
+	struct Backend
+	{
+		const char* name;
+		std::function<std::unique_ptr<BinaryReader::BinaryReader>(const std::string&, const std::vector<uint8_t>&)> make;
+	};
+
+	void
+	writeFile(const std::string& path, const std::vector<uint8_t>& data)
+	{
+		FILE* f = std::fopen(path.c_str(), "wb");
+		if (f == nullptr)
+		{
+			std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+			std::exit(1);
+		}
+		std::fwrite(data.data(), 1, data.size(), f);
+		std::fclose(f);
+	}
+
+#ifdef BINARYREADER_BENCH_ZLIB
+	std::vector<uint8_t>
+	deflateBytes(const std::vector<uint8_t>& data)
+	{
+		uLongf size = compressBound((uLong)data.size());
+		std::vector<uint8_t> out(size);
+		if (compress2(out.data(), &size, data.data(), (uLong)data.size(), Z_BEST_SPEED) != Z_OK)
+		{
+			std::fprintf(stderr, "Cannot compress test data\n");
+			std::exit(1);
+		}
+		out.resize(size);
+		return out;
+	}
+#endif
+
+	void
+	writeJson(const std::string& path, const Options& opts, const std::vector<Result>& results)
+	{
+		FILE* f = std::fopen(path.c_str(), "w");
+		if (f == nullptr)
+		{
+			std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+			return;
+		}
+
+		std::fprintf(f, "{\n  \"size_mib\": %zu,\n  \"budget_s\": %g,\n  \"results\": [\n", opts.sizeMiB, opts.budget);
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			std::fprintf(f, "    {\"backend\": \"%s\", \"kind\": \"%s\", \"ops\": %zu, \"bytes\": %zu, \"seconds\": %.9f, \"ns_per_op\": %.4f, \"gb_per_s\": %.4f}%s\n",
+				r.backend.c_str(), r.kind.c_str(), r.ops, r.bytes, r.seconds,
+				r.seconds * 1e9 / r.ops, r.bytes / r.seconds / 1e9, i + 1 < results.size() ? "," : "");
+		}
+		std::fprintf(f, "  ]\n}\n");
+		std::fclose(f);
+	}
+
+	Options
+	parseArgs(int argc, char** argv)
+	{
+		Options opts;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			auto next = [&]() -> std::string {
+				if (i + 1 >= argc)
+				{
+					std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+					std::exit(1);
+				}
+				return argv[++i];
+			};
+
+			if (arg == "--size")
+				opts.sizeMiB = std::strtoull(next().c_str(), nullptr, 10);
+			else if (arg == "--budget")
+				opts.budget = std::strtod(next().c_str(), nullptr);
+			else if (arg == "--filter")
+				opts.filter = next();
+			else if (arg == "--json")
+				opts.jsonPath = next();
+			else if (arg == "--dir")
+				opts.dir = next();
+			else
+			{
+				std::fprintf(stderr, "Usage: %s [--size MiB] [--budget seconds] [--filter text] [--json path] [--dir path]\n", argv[0]);
+				std::exit(arg == "--help" ? 0 : 1);
+			}
+		}
+		return opts;
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	Options opts = parseArgs(argc, argv);
+	size_t size = std::max<size_t>(opts.sizeMiB, 1) * 1024 * 1024;
+
+	std::mt19937 rng(1234);
+	std::vector<uint8_t> data(size);
+	for (auto& b : data)
+		b = (uint8_t)(rng() & 0x7F);
+
+	// Mostly single-byte values with a tail of longer ones
+	std::vector<uint8_t> lebData;
+	size_t lebValueCount = 0;
+	lebData.reserve(size + 16);
+	while (lebData.size() + 16 < size)
+	{
+		uint64_t value = rng() % 8 == 0 ? rng() : rng() % 128;
+		do
+		{
+			uint8_t b = value & 0x7F;
+			value >>= 7;
+			lebData.push_back(b | (value ? 0x80 : 0));
+		} while (value);
+		lebValueCount++;
+	}
+	lebData.resize(size, 0);
+
+	std::string dataPath = opts.dir + "/binaryreader_bench_data.bin";
+	std::string lebPath = opts.dir + "/binaryreader_bench_leb.bin";
+	writeFile(dataPath, data);
+	writeFile(lebPath, lebData);
+
+	std::vector<Backend> backends = {
+		{ "File", [](const std::string& path, const std::vector<uint8_t>&) {
+			return std::make_unique<BinaryReader::BinaryReaderFile>(path);
+		} },
+		{ "Buffered", [](const std::string&, const std::vector<uint8_t>& bytes) {
+			return std::make_unique<BinaryReader::BinaryReaderBuffered>(std::vector<uint8_t>(bytes));
+		} },
+		{ "Slice", [](const std::string&, const std::vector<uint8_t>& bytes) {
+			return std::make_unique<BinaryReader::BinaryReaderSlice>((uint8_t*)bytes.data(), bytes.size());
+		} },
+		{ "Mapped", [](const std::string& path, const std::vector<uint8_t>&) {
+			return std::make_unique<BinaryReader::BinaryReaderMapped>(path);
+		} },
+		{ "Windowed", [](const std::string& path, const std::vector<uint8_t>&) {
+			return std::make_unique<BinaryReader::BinaryReaderWindowed>(path);
+		} },
+		{ "Prefetched", [](const std::string& path, const std::vector<uint8_t>&) {
+			return std::make_unique<BinaryReader::BinaryReaderPrefetched>(path);
+		} },
+		// The same file as four ranges, so reads cross segment boundaries
+		{ "Segmented", [](const std::string& path, const std::vector<uint8_t>& bytes) {
+			size_t quarter = bytes.size() / 4;
+			std::vector<BinaryReader::Segment> segments;
+			for (size_t i = 0; i < 4; i++)
+				segments.push_back({ path, i * quarter, i < 3 ? quarter : BinaryReader::Segment::WHOLE_FILE });
+			return std::make_unique<BinaryReader::BinaryReaderSegmented>(std::move(segments));
+		} },
+#ifdef BINARYREADER_BENCH_ZLIB
+		{ "Decompressed", [](const std::string&, const std::vector<uint8_t>& bytes) {
+			return std::make_unique<BinaryReader::BinaryReaderDecompressed>(
+				std::make_unique<BinaryReader::BinaryReaderBuffered>(deflateBytes(bytes)),
+				std::make_unique<BinaryReader::ZlibCodec>(), bytes.size());
+		} },
+#endif
+	};
+
+	std::vector<Result> results;
+	for (const auto& backend : backends)
+	{
+		auto dataReader = backend.make(dataPath, data);
+		auto lebReader = backend.make(lebPath, lebData);
+		runBackend<BinaryReader::BinaryReader>(backend.name, *dataReader, *lebReader, lebValueCount, opts, results);
+	}
+
+	// Compile-time dispatch
+	{
+		BinaryReader::BinaryReaderStaticSlice dataReader(data.data(), data.size());
+		BinaryReader::BinaryReaderStaticSlice lebReader(lebData.data(), lebData.size());
+		runBackend<BinaryReader::BinaryReaderStaticSlice>("StaticSlice", dataReader, lebReader, lebValueCount, opts, results);
+	}
+
+	std::remove(dataPath.c_str());
+	std::remove(lebPath.c_str());
+
+	if (!opts.jsonPath.empty())
+		writeJson(opts.jsonPath, opts, results);
+	return 0;
+}
@@ -0,0 +1,1982 @@
+#pragma once
+
+#include "BinaryReaderExceptions.h"
+#include "BinaryReaderResult.h"
+#include "BinaryReaderSimd.h"
+#include "BinaryReaderLeb.h"
+#include "BinaryReaderBits.h"
+#include "BinaryReaderStats.h"
+#include "BinaryReaderStruct.h"
+#include "BinaryReaderInterleaved.h"
+#include "BinaryReaderView.h"
+#include "BinaryReaderStringPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cmath>
+#include <concepts>
+#include <cstdlib>
+#include <ios>
+#include <limits>
+#include <bit>
+#include <utility>
+#include <initializer_list>
+#include <vector>
+#include <span>
+#include <memory_resource>
+
+namespace BinaryReader
+{
+	// Converts floating point infinity to floating point max
+	#define CONV_INF 1
+	// Converts -0 to 0
+	#define CONV_ZERO 2
+	// Throws NonNormalFloatException if float is sub-normal
+	#define FAIL_SUBNORM 4
+
+	// Used for bit-wise operations (limited to 64 bits)
+	const static uint64_t POW2[64] = {	1ULL,					2ULL,					4ULL,
+										8ULL,					16ULL,					32ULL,
+										64ULL,					128ULL,					256ULL,
+										512ULL, 				1024ULL,				2048ULL,
+										4096ULL,				8192ULL,				16384ULL,
+										32768ULL,				65536ULL,				131072ULL,
+										262144ULL,				524288ULL,				1048576ULL,
+										2097152ULL,				4194304ULL,				8388608ULL,
+										16777216ULL,			33554432ULL,			67108864ULL,
+										134217728ULL,			268435456ULL,			536870912ULL,
+										1073741824ULL,			2147483648ULL,			4294967296ULL,
+										8589934592ULL,			17179869184ULL,			34359738368ULL,
+										68719476736ULL,			137438953472ULL,		274877906944ULL,
+										549755813888ULL, 		1099511627776ULL,		2199023255552ULL,
+										4398046511104ULL, 		8796093022208ULL,		17592186044416ULL,
+										35184372088832ULL,		70368744177664ULL,		140737488355328ULL,
+										281474976710656ULL, 	562949953421312ULL,		1125899906842624ULL,
+										2251799813685248ULL, 	4503599627370496ULL,	9007199254740992ULL,
+										18014398509481984ULL,	36028797018963968ULL,	72057594037927936ULL,
+										144115188075855872ULL,	288230376151711744ULL,	576460752303423488ULL,
+										1152921504606846976ULL,	2305843009213693952ULL,	4611686018427387904ULL,
+										9223372036854775808ULL};
+
+	// Whether memory-backed readers check that each read stays inside their data
+	// Defining BINARYREADER_BOUNDS_CHECK turns the checks on for Buffered, Slice, Mapped and StaticSlice
+	enum class Bounds
+	{
+		Unchecked,
+		Checked
+	};
+
+#ifdef BINARYREADER_BOUNDS_CHECK
+	inline constexpr Bounds DEFAULT_BOUNDS = Bounds::Checked;
+#else
+	inline constexpr Bounds DEFAULT_BOUNDS = Bounds::Unchecked;
+#endif
+
+	// Defined in BinaryReaderStaticSlice.h
+	template <Bounds Policy>
+	class BasicStaticSlice;
+
+	template <class T>
+	concept isSimpleComparable = requires(T a, T b)
+	{
+		a < b;
+		a > b;
+	};
+
+	namespace Parallel
+	{
+		struct Access;
+	}
+
+	// The full read API, dispatched at compile time onto `Derived`
+	// `Derived` must provide readBytes, seek, tell and getLength
+	// BinaryReader is the virtual instantiation; final backends get fully inlined reads
+	template <class Derived>
+	class BasicReader
+	{
+		template <class Reader>
+		friend class BitReader;
+		friend struct Parallel::Access;
+
+		int m_bitOffset;
+#ifdef BINARYREADER_STATS
+		ReaderStats m_stats;
+		// Set while BasicReader moves the cursor for its own bookkeeping
+		bool m_statsMuted = false;
+#endif
+
+	public:
+		BasicReader() : m_bitOffset(0) {};
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Basic read. Use this for structs
+
+		template <typename T>
+		T
+		read()
+		{
+			T data;
+			_readBytes(&data, sizeof(data));
+			return data;
+		}
+
+		// Struct with per-member byte order, described by a StructLayout
+		template <class Layout>
+		typename Layout::Type
+		readStruct()
+		{
+			typename Layout::Type data;
+			_readBytes(&data, sizeof(data));
+			Layout::fixup(&data, 1);
+			return data;
+		}
+
+		// One bulk read, then the swapped members of every element are fixed up together
+		template <class Layout>
+		void
+		readStructArray(typename Layout::Type* dst, size_t count)
+		{
+			_readBytes(dst, sizeof(typename Layout::Type) * count);
+			Layout::fixup(dst, count);
+		}
+
+		// Splits `count` interleaved records of `stride` bytes into one contiguous array per attribute
+		// Memory-backed readers are decoded in place; others are copied in 64 KiB chunks first
+		void
+		readInterleaved(size_t stride, size_t count, const Attribute* attributes, size_t attributeCount)
+		{
+			if (count == 0)
+				return;
+			Interleaved::validate(stride, attributes, attributeCount);
+
+			std::vector<uint8_t> chunk;
+			size_t done = 0;
+			while (done < count)
+			{
+				size_t remaining = 0;
+				const uint8_t* src = _self().cursorPtr(remaining);
+				// Blocks stay cache-resident while each attribute makes its pass
+				size_t block = std::max<size_t>(1, 64 * 1024 / stride);
+				size_t n = src != nullptr ? std::min({ count - done, remaining / stride, block }) : 0;
+				if (n > 0)
+				{
+					Interleaved::decode(src, stride, n, done, attributes, attributeCount);
+					_statConsumed(n * stride);
+					_seekQuiet(n * stride, std::ios::cur);
+					done += n;
+					continue;
+				}
+
+				// Also covers a record straddling the end of a memory view
+				n = std::min(count - done, block);
+				chunk.resize(n * stride);
+				_readBytes(chunk.data(), n * stride);
+				Interleaved::decode(chunk.data(), stride, n, done, attributes, attributeCount);
+				done += n;
+			}
+		}
+
+		void
+		readInterleaved(size_t stride, size_t count, std::initializer_list<Attribute> attributes)
+		{
+			readInterleaved(stride, count, attributes.begin(), attributes.size());
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Positional reads
+		// These never touch the cursor, so one reader can serve many threads
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		T
+		readAt(size_t offset) const
+		{
+			T data;
+			_self().readBytesAt(&data, sizeof(T), offset);
+			return Simd::toNative<std::endian::little>(data);
+		}
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		T
+		readAtBE(size_t offset) const
+		{
+			T data;
+			_self().readBytesAt(&data, sizeof(T), offset);
+			return Simd::toNative<std::endian::big>(data);
+		}
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		void
+		readArrayAt(size_t offset, T* dst, size_t count) const
+		{
+			_self().readBytesAt(dst, sizeof(T) * count, offset);
+			Simd::toNativeArray<std::endian::little>(dst, count);
+		}
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		void
+		readArrayAtBE(size_t offset, T* dst, size_t count) const
+		{
+			_self().readBytesAt(dst, sizeof(T) * count, offset);
+			Simd::toNativeArray<std::endian::big>(dst, count);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Scalars
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		T
+		readScalar()
+		{
+			T data = _readScalarIn<T, std::endian::little>();
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		T
+		readScalarSafe(T min, T max, const DebugMessage& debugMsg)
+		{
+			T data = _readScalarIn<T, std::endian::little>();
+
+			if (data < min)
+				throw _statFailure(LimitException(data, min, debugMsg));
+			else if (data >= max)
+				throw _statFailure(LimitException(data, max, debugMsg));
+
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		T
+		readScalarSafe(T exact, const DebugMessage& debugMsg)
+		{
+			T data = _readScalarIn<T, std::endian::little>();
+
+			if (data != exact)
+				throw _statFailure(LimitException(data, exact, debugMsg));
+
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		T
+		readScalarBE()
+		{
+			T data = _readScalarIn<T, std::endian::big>();
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		T
+		readScalarBESafe(T min, T max, const DebugMessage& debugMsg)
+		{
+			T data = _readScalarIn<T, std::endian::big>();
+
+			if (data < min)
+				throw _statFailure(LimitException(data, min, debugMsg));
+			else if (data >= max)
+				throw _statFailure(LimitException(data, max, debugMsg));
+
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		T
+		readScalarBESafe(T exact, const DebugMessage& debugMsg)
+		{
+			T data = _readScalarIn<T, std::endian::big>();
+
+			if (data != exact)
+				throw _statFailure(LimitException(data, exact, debugMsg));
+
+			return data;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Scalar Arrays
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		void
+		readScalarArray(T* dst, size_t count)
+		{
+			_readArrayIn<std::endian::little>(dst, count);
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		void
+		readScalarArraySafe(T* dst, size_t count, T min, T max, const DebugMessage& debugMsg)
+		{
+			_readCheckedArray<std::endian::little>(dst, count, min, max, debugMsg);
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		void
+		readScalarArraySafe(T* dst, size_t count, T exact, const DebugMessage& debugMsg)
+		{
+			_readCheckedArray<std::endian::little>(dst, count, exact, debugMsg);
+		}
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		void
+		readScalarArrayBE(T* dst, size_t count)
+		{
+			_readArrayIn<std::endian::big>(dst, count);
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		void
+		readScalarArrayBESafe(T* dst, size_t count, T min, T max, const DebugMessage& debugMsg)
+		{
+			_readCheckedArray<std::endian::big>(dst, count, min, max, debugMsg);
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		void
+		readScalarArrayBESafe(T* dst, size_t count, T exact, const DebugMessage& debugMsg)
+		{
+			_readCheckedArray<std::endian::big>(dst, count, exact, debugMsg);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Vectors
+		// Storage comes from `resource`, so a caller-owned std::pmr::monotonic_buffer_resource can hold
+		//   all of one file's results and free them at once. The default resource is plain new/delete
+		// A count that runs past the end of the data throws out_of_range before anything is allocated
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		std::pmr::vector<T>
+		readVector(size_t count, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			std::pmr::vector<T> ret(_checkedCount(count, sizeof(T)), resource);
+			readScalarArray(ret.data(), count);
+			return ret;
+		}
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		std::pmr::vector<T>
+		readVectorBE(size_t count, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			std::pmr::vector<T> ret(_checkedCount(count, sizeof(T)), resource);
+			readScalarArrayBE(ret.data(), count);
+			return ret;
+		}
+
+		std::pmr::vector<uint64_t>
+		readULEBVector(size_t count, std::pmr::memory_resource* resource = std::pmr::get_default_resource(), int maxBits = 64)
+		{
+			// Every value takes at least one byte
+			std::pmr::vector<uint64_t> ret(_checkedCount(count, 1), resource);
+			readULEBArray(ret.data(), count, maxBits);
+			return ret;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Float Overloads
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		T
+		readScalarSafe(T min, T max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			T data = _readScalarIn<T, std::endian::little>();
+			data = _checkFloat<T>(data, min, max, flags, debugMsg);
+			return data;
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		T
+		readScalarSafe(T exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			T data = _readScalarIn<T, std::endian::little>();
+			data = _checkFloat<T>(data, exact, flags, debugMsg);
+			return data;
+		}
+
+		// Dunno if BE floats are actually used
+		// But here's the code anyway
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		T
+		readScalarBESafe(T min, T max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			T data = _readScalarIn<T, std::endian::big>();
+			data = _checkFloat<T>(data, min, max, flags, debugMsg);
+			return data;
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		T
+		readScalarBESafe(T exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			T data = _readScalarIn<T, std::endian::big>();
+			data = _checkFloat<T>(data, exact, flags, debugMsg);
+			return data;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Float Array Overloads
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		void
+		readScalarArraySafe(T* dst, size_t count, T min, T max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			_readCheckedFloatArray<T, std::endian::little>(dst, count, min, max, flags, debugMsg);
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		void
+		readScalarArraySafe(T* dst, size_t count, T exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			_readCheckedFloatArray<T, std::endian::little>(dst, count, exact, flags, debugMsg);
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		void
+		readScalarArrayBESafe(T* dst, size_t count, T min, T max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			_readCheckedFloatArray<T, std::endian::big>(dst, count, min, max, flags, debugMsg);
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		void
+		readScalarArrayBESafe(T* dst, size_t count, T exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			_readCheckedFloatArray<T, std::endian::big>(dst, count, exact, flags, debugMsg);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Bit-wise Scalars
+
+		template <typename T>
+		requires std::integral<T>
+		T
+		readBitwiseScalar(int readBitCount)
+		{
+			if (readBitCount == 0)
+				throw std::invalid_argument("Read bits cannot be 0");
+			if (readBitCount > 64)
+				throw std::invalid_argument("Read bits cannot be >= 64");
+			
+			int bytesToRead = (m_bitOffset + readBitCount + 7) / 8;
+			T retValue = _readBitwiseScalar<T>(readBitCount, bytesToRead);
+			m_bitOffset = (m_bitOffset + readBitCount) % 8;
+			// More data in the previous position
+			if (m_bitOffset > 0)
+				_seekQuiet(-1, std::ios::cur);
+
+			return retValue;
+		}
+
+		// For packed streams, prefer BitReader over repeated readBitwiseScalar calls
+		// This reads the whole array through one and leaves the cursor at the next unread bit
+		template <typename T>
+		requires std::integral<T>
+		void
+		readBitwiseArray(int readBitCount, size_t count, T* dst)
+		{
+			BitReader<Derived> bits(_self());
+			bits.template readBitwiseArray<T>(readBitCount, count, dst);
+			// Explicit, so a failing seek is reported instead of swallowed by the destructor
+			bits.sync();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Half-Floats
+
+		float
+		readHalf()
+		{
+			return _readHalfFloat();
+		}
+
+		float
+		readHalfSafe(float min, float max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			float data = _readHalfFloat();
+			return _checkFloat<float>(data, min, max, flags, debugMsg);
+		}
+
+		float
+		readHalfSafe(float exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			float data = _readHalfFloat();
+			return _checkFloat<float>(data, exact, flags, debugMsg);
+		}
+
+
+		void
+		readHalfArray(float* dst, size_t count)
+		{
+			_readHalfArrayIn<std::endian::little>(dst, count);
+		}
+
+		void
+		readHalfArraySafe(float* dst, size_t count, float min, float max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			_readCheckedFloatArray<uint16_t, std::endian::little>(dst, count, min, max, flags, debugMsg);
+		}
+
+		void
+		readHalfArraySafe(float* dst, size_t count, float exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			_readCheckedFloatArray<uint16_t, std::endian::little>(dst, count, exact, flags, debugMsg);
+		}
+
+		float
+		readHalfBE()
+		{
+			return _readHalfFloat<std::endian::big>();
+		}
+
+		float
+		readHalfBESafe(float min, float max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			float data = _readHalfFloat<std::endian::big>();
+			return _checkFloat<float>(data, min, max, flags, debugMsg);
+		}
+
+		float
+		readHalfBESafe(float exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			float data = _readHalfFloat<std::endian::big>();
+			return _checkFloat<float>(data, exact, flags, debugMsg);
+		}
+
+		void
+		readHalfArrayBE(float* dst, size_t count)
+		{
+			_readHalfArrayIn<std::endian::big>(dst, count);
+		}
+
+		void
+		readHalfArrayBESafe(float* dst, size_t count, float min, float max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			_readCheckedFloatArray<uint16_t, std::endian::big>(dst, count, min, max, flags, debugMsg);
+		}
+
+		void
+		readHalfArrayBESafe(float* dst, size_t count, float exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			_readCheckedFloatArray<uint16_t, std::endian::big>(dst, count, exact, flags, debugMsg);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// LEB
+
+		uint64_t
+		readULEB(int maxBits = 64)
+		{
+			return _readULEB(maxBits);
+		}
+
+		uint64_t
+		readULEBSafe(uint64_t min, uint64_t max, const DebugMessage& debugMsg, int maxBits = 64)
+		{
+			uint64_t data = _readULEB(maxBits);
+
+			if (data < min)
+				throw _statFailure(LimitException(data, min, debugMsg));
+			else if (data >= max)
+				throw _statFailure(LimitException(data, max, debugMsg));
+
+			return data;
+		}
+
+		uint64_t
+		readULEBSafe(uint64_t exact, const DebugMessage& debugMsg, int maxBits = 64)
+		{
+			uint64_t data = _readULEB(maxBits);
+
+			if (data != exact)
+				throw _statFailure(LimitException(data, exact, debugMsg));
+
+			return data;
+		}
+
+		void
+		readULEBArray(uint64_t* dst, size_t count, int maxBits = 64)
+		{
+			_readULEBArrayUntil(dst, count, maxBits, [](const uint64_t*, size_t n) { return n; });
+		}
+
+		void
+		readULEBArraySafe(uint64_t* dst, size_t count, uint64_t min, uint64_t max, const DebugMessage& debugMsg, int maxBits = 64)
+		{
+			size_t i = _readULEBArrayUntil(dst, count, maxBits,
+				[&](const uint64_t* values, size_t n) { return Simd::findOutOfRange(values, n, min, max); });
+			if (i == count)
+				return;
+
+			if (dst[i] < min)
+				throw _statFailure(LimitException(dst[i], min, i, debugMsg));
+			else
+				throw _statFailure(LimitException(dst[i], max, i, debugMsg));
+		}
+
+		void
+		readULEBArraySafe(uint64_t* dst, size_t count, uint64_t exact, const DebugMessage& debugMsg, int maxBits = 64)
+		{
+			size_t i = _readULEBArrayUntil(dst, count, maxBits,
+				[&](const uint64_t* values, size_t n) { return Simd::findNotEqual(values, n, exact); });
+			if (i == count)
+				return;
+
+			throw _statFailure(LimitException(dst[i], exact, i, debugMsg));
+		}
+
+		// Sorted ID lists stored as gaps. Each value is added to the previous one, starting from `base`
+		void
+		readULEBArrayDelta(uint64_t* dst, size_t count, uint64_t base = 0, int maxBits = 64)
+		{
+			readULEBArray(dst, count, maxBits);
+
+			uint64_t running = base;
+			for (size_t i = 0; i < count; i++)
+			{
+				running += dst[i];
+				dst[i] = running;
+			}
+		}
+
+		int64_t
+		readSLEB(int maxBits = 64)
+		{
+			return _readSLEB(maxBits);
+		}
+
+		void
+		readSLEBArray(int64_t* dst, size_t count, int maxBits = 64)
+		{
+			size_t done = 0;
+			while (done < count)
+			{
+				size_t remaining = 0;
+				const uint8_t* src = _self().cursorPtr(remaining);
+				if (src == nullptr)
+				{
+					for (; done < count; done++)
+						dst[done] = _readSLEB(maxBits);
+					return;
+				}
+
+				size_t decoded = 0;
+				size_t used = Leb::decodeSLEBArray(src, remaining, dst + done, count - done, decoded, maxBits);
+				_statConsumed(used);
+				_seekQuiet(used, std::ios::cur);
+				done += decoded;
+
+				if (done < count)
+					dst[done++] = _readSLEB(maxBits);
+			}
+		}
+
+		// ULEB holding a zigzag-encoded signed value (0, -1, 1, -2, ...)
+		int64_t
+		readZigZagLEB(int maxBits = 64)
+		{
+			return Leb::zigZagDecode(_readULEB(maxBits));
+		}
+
+		void
+		readZigZagLEBArray(int64_t* dst, size_t count, int maxBits = 64)
+		{
+			readULEBArray((uint64_t*)dst, count, maxBits);
+			for (size_t i = 0; i < count; i++)
+				dst[i] = Leb::zigZagDecode((uint64_t)dst[i]);
+		}
+
+#ifdef BINARYREADER_HAS_EXPECTED
+		//////////////////////////////////////////////////////////////////////////////
+		// Non-throwing checks
+		// Same checks as the Safe reads, but failures come back as a ReadError instead of an exception
+		// The cursor ends up where the Safe read would leave it: just past the failing element
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		ReadResult<T>
+		tryReadScalar(T min, T max)
+		{
+			T data = readScalar<T>();
+			if (data < min || data >= max)
+				return std::unexpected(_statFailure(_rangeError(data, min, max, 0)));
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		ReadResult<T>
+		tryReadScalar(T exact)
+		{
+			T data = readScalar<T>();
+			if (data != exact)
+				return std::unexpected(_statFailure(ReadError<T>{ ReadErrorKind::NotExact, 0, data, exact }));
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		ReadResult<T>
+		tryReadScalarBE(T min, T max)
+		{
+			T data = readScalarBE<T>();
+			if (data < min || data >= max)
+				return std::unexpected(_statFailure(_rangeError(data, min, max, 0)));
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		ReadResult<T>
+		tryReadScalarBE(T exact)
+		{
+			T data = readScalarBE<T>();
+			if (data != exact)
+				return std::unexpected(_statFailure(ReadError<T>{ ReadErrorKind::NotExact, 0, data, exact }));
+			return data;
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		ReadResult<T, void>
+		tryReadScalarArray(T* dst, size_t count, T min, T max)
+		{
+			return _tryReadArray<std::endian::little>(dst, count, min, max);
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		ReadResult<T, void>
+		tryReadScalarArray(T* dst, size_t count, T exact)
+		{
+			return _tryReadArray<std::endian::little>(dst, count, exact);
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		ReadResult<T, void>
+		tryReadScalarArrayBE(T* dst, size_t count, T min, T max)
+		{
+			return _tryReadArray<std::endian::big>(dst, count, min, max);
+		}
+
+		template <typename T>
+		requires std::integral<T> && isSimpleComparable<T>
+		ReadResult<T, void>
+		tryReadScalarArrayBE(T* dst, size_t count, T exact)
+		{
+			return _tryReadArray<std::endian::big>(dst, count, exact);
+		}
+
+		// Floats are returned with the CONV_* flags applied
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		ReadResult<T>
+		tryReadScalar(T min, T max, uint8_t flags)
+		{
+			T fixed;
+			ReadError<T> error;
+			if (!_validateFloat(readScalar<T>(), min, max, flags, fixed, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return fixed;
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		ReadResult<T>
+		tryReadScalar(T exact, uint8_t flags)
+		{
+			T fixed;
+			ReadError<T> error;
+			if (!_validateFloat(readScalar<T>(), exact, flags, fixed, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return fixed;
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		ReadResult<T, void>
+		tryReadScalarArray(T* dst, size_t count, T min, T max, uint8_t flags)
+		{
+			return _tryReadFloatArray<T, std::endian::little>(dst, count, min, max, flags);
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		ReadResult<T, void>
+		tryReadScalarArray(T* dst, size_t count, T exact, uint8_t flags)
+		{
+			return _tryReadFloatArray<T, std::endian::little>(dst, count, exact, flags);
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		ReadResult<T>
+		tryReadScalarBE(T min, T max, uint8_t flags)
+		{
+			T fixed;
+			ReadError<T> error;
+			if (!_validateFloat(readScalarBE<T>(), min, max, flags, fixed, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return fixed;
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		ReadResult<T>
+		tryReadScalarBE(T exact, uint8_t flags)
+		{
+			T fixed;
+			ReadError<T> error;
+			if (!_validateFloat(readScalarBE<T>(), exact, flags, fixed, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return fixed;
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		ReadResult<T, void>
+		tryReadScalarArrayBE(T* dst, size_t count, T min, T max, uint8_t flags)
+		{
+			return _tryReadFloatArray<T, std::endian::big>(dst, count, min, max, flags);
+		}
+
+		template <typename T>
+		requires std::floating_point<T> && isSimpleComparable<T>
+		ReadResult<T, void>
+		tryReadScalarArrayBE(T* dst, size_t count, T exact, uint8_t flags)
+		{
+			return _tryReadFloatArray<T, std::endian::big>(dst, count, exact, flags);
+		}
+
+		ReadResult<float>
+		tryReadHalf(float min, float max, uint8_t flags)
+		{
+			float fixed;
+			ReadError<float> error;
+			if (!_validateFloat(_readHalfFloat(), min, max, flags, fixed, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return fixed;
+		}
+
+		ReadResult<float>
+		tryReadHalf(float exact, uint8_t flags)
+		{
+			float fixed;
+			ReadError<float> error;
+			if (!_validateFloat(_readHalfFloat(), exact, flags, fixed, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return fixed;
+		}
+
+		ReadResult<float, void>
+		tryReadHalfArray(float* dst, size_t count, float min, float max, uint8_t flags)
+		{
+			return _tryReadFloatArray<uint16_t, std::endian::little>(dst, count, min, max, flags);
+		}
+
+		ReadResult<float, void>
+		tryReadHalfArray(float* dst, size_t count, float exact, uint8_t flags)
+		{
+			return _tryReadFloatArray<uint16_t, std::endian::little>(dst, count, exact, flags);
+		}
+
+		ReadResult<float>
+		tryReadHalfBE(float min, float max, uint8_t flags)
+		{
+			float fixed;
+			ReadError<float> error;
+			if (!_validateFloat(_readHalfFloat<std::endian::big>(), min, max, flags, fixed, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return fixed;
+		}
+
+		ReadResult<float>
+		tryReadHalfBE(float exact, uint8_t flags)
+		{
+			float fixed;
+			ReadError<float> error;
+			if (!_validateFloat(_readHalfFloat<std::endian::big>(), exact, flags, fixed, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return fixed;
+		}
+
+		ReadResult<float, void>
+		tryReadHalfArrayBE(float* dst, size_t count, float min, float max, uint8_t flags)
+		{
+			return _tryReadFloatArray<uint16_t, std::endian::big>(dst, count, min, max, flags);
+		}
+
+		ReadResult<float, void>
+		tryReadHalfArrayBE(float* dst, size_t count, float exact, uint8_t flags)
+		{
+			return _tryReadFloatArray<uint16_t, std::endian::big>(dst, count, exact, flags);
+		}
+
+		ReadResult<uint64_t>
+		tryReadULEB(uint64_t min, uint64_t max, int maxBits = 64)
+		{
+			uint64_t data = _readULEB(maxBits);
+			if (data < min || data >= max)
+				return std::unexpected(_statFailure(_rangeError(data, min, max, 0)));
+			return data;
+		}
+
+		// No maxBits here: tryReadULEB(1, 5) must mean the range [1, 5)
+		ReadResult<uint64_t>
+		tryReadULEB(uint64_t exact)
+		{
+			uint64_t data = _readULEB(64);
+			if (data != exact)
+				return std::unexpected(_statFailure(ReadError<uint64_t>{ ReadErrorKind::NotExact, 0, data, exact }));
+			return data;
+		}
+
+		ReadResult<uint64_t, void>
+		tryReadULEBArray(uint64_t* dst, size_t count, uint64_t min, uint64_t max, int maxBits = 64)
+		{
+			size_t i = _readULEBArrayUntil(dst, count, maxBits,
+				[&](const uint64_t* values, size_t n) { return Simd::findOutOfRange(values, n, min, max); });
+			if (i == count)
+				return {};
+			return std::unexpected(_statFailure(_rangeError(dst[i], min, max, i)));
+		}
+
+		ReadResult<uint64_t, void>
+		tryReadULEBArray(uint64_t* dst, size_t count, uint64_t exact)
+		{
+			size_t i = _readULEBArrayUntil(dst, count, 64,
+				[&](const uint64_t* values, size_t n) { return Simd::findNotEqual(values, n, exact); });
+			if (i == count)
+				return {};
+			return std::unexpected(_statFailure(ReadError<uint64_t>{ ReadErrorKind::NotExact, i, dst[i], exact }));
+		}
+#endif
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Strings
+		// read* return an owned std::string and work on every reader
+		// view* return a std::string_view into the reader's memory, under the same rules as the zero-copy views below
+		// The StringPool overloads intern the string without building a std::string when it is in memory
+
+		// Null-terminated. The cursor ends up past the terminator
+		std::string
+		readCString()
+		{
+			std::string scratch;
+			std::string_view str = _readCString(scratch);
+			if (scratch.empty())
+				return std::string(str);
+			return scratch;
+		}
+
+		std::string_view
+		readCString(StringPool& pool)
+		{
+			std::string scratch;
+			return pool.intern(_readCString(scratch));
+		}
+
+		// Length-prefixed, with a LenT byte count
+		template <std::unsigned_integral LenT>
+		std::string
+		readPrefixedString()
+		{
+			std::string scratch;
+			std::string_view str = _readSizedString(readScalar<LenT>(), scratch);
+			if (scratch.empty())
+				return std::string(str);
+			return scratch;
+		}
+
+		template <std::unsigned_integral LenT>
+		std::string_view
+		readPrefixedString(StringPool& pool)
+		{
+			std::string scratch;
+			return pool.intern(_readSizedString(readScalar<LenT>(), scratch));
+		}
+
+		// Prefixed with a ULEB byte count
+		std::string
+		readULEBString()
+		{
+			std::string scratch;
+			std::string_view str = _readSizedString(_readULEB(64), scratch);
+			if (scratch.empty())
+				return std::string(str);
+			return scratch;
+		}
+
+		std::string_view
+		readULEBString(StringPool& pool)
+		{
+			std::string scratch;
+			return pool.intern(_readSizedString(_readULEB(64), scratch));
+		}
+
+		// Throws out_of_range if the terminator isn't in the reader's contiguous memory
+		std::string_view
+		viewCString()
+		{
+			size_t remaining = 0;
+			const uint8_t* src = _self().cursorPtr(remaining);
+			if (src == nullptr)
+				throw std::logic_error("Views need a memory-backed reader");
+
+			const void* end = std::memchr(src, 0, remaining);
+			if (end == nullptr)
+				throw std::out_of_range("String is not terminated in memory");
+
+			size_t length = (const uint8_t*)end - src;
+			_statConsumed(length + 1);
+			_seekQuiet(length + 1, std::ios::cur);
+			return std::string_view((const char*)src, length);
+		}
+
+		// On failure the cursor is put back before the length prefix, so the read* version can be used instead
+		template <std::unsigned_integral LenT>
+		std::string_view
+		viewPrefixedString()
+		{
+			size_t start = _self().tell();
+			return _viewSizedString(start, readScalar<LenT>());
+		}
+
+		std::string_view
+		viewULEBString()
+		{
+			size_t start = _self().tell();
+			return _viewSizedString(start, _readULEB(64));
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Zero-copy views
+		// Views point into the reader's memory and advance the cursor without copying
+		// They stay valid as long as the reader's buffer does: the whole lifetime for Buffered, Slice and Mapped,
+		//   but only until the next read for readers with a window (Windowed, Prefetched, Decompressed)
+
+		// Reads a T without moving the cursor. Works on every reader
+		template <typename T>
+		requires std::is_trivially_copyable_v<T>
+		T
+		peek()
+		{
+			T data;
+			size_t remaining = 0;
+			const uint8_t* src = _self().cursorPtr(remaining);
+			if (src != nullptr && remaining >= sizeof(T))
+			{
+				std::memcpy(&data, src, sizeof(T));
+				return data;
+			}
+
+			_readBytes(&data, sizeof(T));
+			_seekQuiet(-(std::streamoff)sizeof(T), std::ios::cur);
+			return data;
+		}
+
+		std::span<const uint8_t>
+		viewBytes(size_t count)
+		{
+			const uint8_t* src = _view(count);
+			return std::span<const uint8_t>(src, count);
+		}
+
+		template <typename T>
+		requires std::is_trivially_copyable_v<T>
+		UnalignedView<T>
+		viewArray(size_t count)
+		{
+			const uint8_t* src = _view(sizeof(T) * count);
+			return UnalignedView<T>(src, count);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Other members
+
+		// Throws out_of_range unless at least `count` bytes are left. Works on every reader
+		Derived&
+		ensure(size_t count)
+		{
+			if (_available() < count)
+				throw std::out_of_range("Not enough data left");
+			return _self();
+		}
+
+		// Checks once that a `count`-byte record is in memory, then hands it out as an unchecked slice and moves past it
+		// The record's fields are read with plain loads even when BINARYREADER_BOUNDS_CHECK is defined
+		// Needs a memory-backed reader; the slice is valid as long as a view would be
+		BasicStaticSlice<Bounds::Unchecked> record(size_t count);
+
+		// Bytes at the cursor on memory-backed readers, nullptr otherwise
+		// `remaining` is how many contiguous bytes are valid from there
+		const uint8_t*
+		cursorData(size_t& remaining)
+		{
+			return _self().cursorPtr(remaining);
+		}
+
+		int
+		tellBit() const
+		{
+			return m_bitOffset;
+		}
+
+		Derived&
+		seekBit(int count, std::ios_base::seekdir way)
+		{
+			int seekTo = m_bitOffset;
+			switch(way)
+			{
+			case(std::ios::beg):
+				seekTo = count;
+				break;
+			case(std::ios::cur):
+				seekTo += count;
+				break;
+			// Silly
+			case(std::ios::end):
+				seekTo = 7 - count;
+				break;
+			}
+
+			std::div_t bytesAndBits = std::div(seekTo, 8);
+			int bytesToSeek = bytesAndBits.quot;
+			int bitsToSeek = bytesAndBits.rem;
+			if (bitsToSeek < 0)
+			{
+				bytesToSeek -= 1;
+				bitsToSeek = 7 - bytesAndBits.rem;
+			}
+
+			_self().seek(bytesToSeek, std::ios::cur);
+			m_bitOffset = bitsToSeek;
+
+			return _self();
+		}
+
+		// Counters since construction or the last resetStats(). All zero unless BINARYREADER_STATS is defined
+		ReaderStats
+		stats() const
+		{
+#ifdef BINARYREADER_STATS
+			return m_stats;
+#else
+			return {};
+#endif
+		}
+
+		void
+		resetStats()
+		{
+#ifdef BINARYREADER_STATS
+			m_stats = {};
+#endif
+		}
+
+	protected:
+		// Backends call this at the top of seek, before moving the cursor
+		void
+		_statSeek([[maybe_unused]] std::streamoff offset, [[maybe_unused]] std::ios_base::seekdir way)
+		{
+#ifdef BINARYREADER_STATS
+			if (m_statsMuted)
+				return;
+			size_t from = _self().tell();
+			size_t to = from + offset;
+			if (way == std::ios::beg)
+				to = offset;
+			else if (way == std::ios::end)
+				to = _self().getLength() + offset;
+			m_stats.recordSeek(from, to);
+#endif
+		}
+
+	private:
+		Derived&
+		_self()
+		{
+			return static_cast<Derived&>(*this);
+		}
+
+		const Derived&
+		_self() const
+		{
+			return static_cast<const Derived&>(*this);
+		}
+
+		// Throws if the next `count` bytes aren't contiguous in the reader's memory
+		const uint8_t*
+		_view(size_t count)
+		{
+			size_t remaining = 0;
+			const uint8_t* src = _self().cursorPtr(remaining);
+			if (src == nullptr)
+				throw std::logic_error("Views need a memory-backed reader");
+			if (remaining < count)
+				throw std::out_of_range("View is not available in memory");
+
+			_statConsumed(count);
+			_seekQuiet(count, std::ios::cur);
+			return src;
+		}
+
+		// Bytes left before the end of the data
+		size_t
+		_available()
+		{
+			size_t length = _self().getLength();
+			size_t pos = _self().tell();
+			return pos < length ? length - pos : 0;
+		}
+
+		// `count` elements of at least `minSize` bytes each must fit in the rest of the data
+		size_t
+		_checkedCount(size_t count, size_t minSize)
+		{
+			if (count > _available() / minSize)
+				throw std::out_of_range("Element count is past the end of the data");
+			return count;
+		}
+
+		// The strings below return a view of the reader's memory when the whole string is contiguous there
+		// Otherwise the string is copied into `scratch` and the view is of that
+		std::string_view
+		_readCString(std::string& scratch)
+		{
+			// The terminator scan is memchr, which the standard libraries vectorize
+			size_t remaining = 0;
+			const uint8_t* src = _self().cursorPtr(remaining);
+			while (src != nullptr && remaining > 0)
+			{
+				const void* end = std::memchr(src, 0, remaining);
+				size_t length = end != nullptr ? (const uint8_t*)end - src : remaining;
+				size_t consumed = end != nullptr ? length + 1 : length;
+				_statConsumed(consumed);
+				_seekQuiet(consumed, std::ios::cur);
+
+				if (end != nullptr && scratch.empty())
+					return std::string_view((const char*)src, length);
+				scratch.append((const char*)src, length);
+				if (end != nullptr)
+					return scratch;
+
+				// Straddles the end of a window; carry on in the next one
+				src = _self().cursorPtr(remaining);
+			}
+
+			// No memory to scan: read small chunks and give back what follows the terminator
+			uint8_t chunk[64];
+			while (true)
+			{
+				size_t count = std::min(sizeof(chunk), _available());
+				if (count == 0)
+					throw std::out_of_range("String is not terminated");
+				_readBytes(chunk, count);
+
+				const void* end = std::memchr(chunk, 0, count);
+				if (end == nullptr)
+				{
+					scratch.append((const char*)chunk, count);
+					continue;
+				}
+
+				size_t length = (const uint8_t*)end - chunk;
+				scratch.append((const char*)chunk, length);
+				_seekQuiet(-(std::streamoff)(count - length - 1), std::ios::cur);
+				return scratch;
+			}
+		}
+
+		std::string_view
+		_readSizedString(uint64_t length, std::string& scratch)
+		{
+			size_t remaining = 0;
+			const uint8_t* src = _self().cursorPtr(remaining);
+			if (src != nullptr && remaining >= length)
+			{
+				_statConsumed(length);
+				_seekQuiet(length, std::ios::cur);
+				return std::string_view((const char*)src, length);
+			}
+
+			// Corrupt lengths would otherwise turn into huge allocations
+			if (length > _available())
+				throw std::out_of_range("String length is past the end of the data");
+			scratch.resize(length);
+			_readBytes(scratch.data(), length);
+			return scratch;
+		}
+
+		std::string_view
+		_viewSizedString(size_t start, uint64_t length)
+		{
+			try
+			{
+				const uint8_t* src = _view(length);
+				return std::string_view((const char*)src, length);
+			}
+			catch (...)
+			{
+				_seekQuiet(start, std::ios::beg);
+				throw;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Instrumented access to the backend
+
+		template <typename Count>
+		void
+		_readBytes(void* dst, Count count)
+		{
+#ifdef BINARYREADER_STATS
+			m_stats.recordRead(count, false);
+#endif
+			_readBackend(dst, (size_t)count);
+		}
+
+		// Backends take an int count, so bulk reads of 2 GiB or more are handed to them in pieces
+		void
+		_readBackend(void* dst, size_t count)
+		{
+			constexpr size_t MAX_PIECE = (size_t)std::numeric_limits<int>::max();
+			uint8_t* out = (uint8_t*)dst;
+			while (count > MAX_PIECE)
+			{
+				_self().readBytes(out, (int)MAX_PIECE);
+				out += MAX_PIECE;
+				count -= MAX_PIECE;
+			}
+			_self().readBytes(out, (int)count);
+		}
+
+		// Big-endian data is read like any other and swapped afterwards, so it never goes through a slower backend path
+		template <typename T, std::endian Order>
+		T
+		_readScalarIn()
+		{
+			T data;
+#ifdef BINARYREADER_STATS
+			m_stats.recordRead(sizeof(T), Order == std::endian::big);
+#endif
+			_self().readBytes(&data, sizeof(T));
+			return Simd::toNative<Order>(data);
+		}
+
+		template <std::endian Order, typename T>
+		void
+		_readArrayIn(T* dst, size_t count)
+		{
+#ifdef BINARYREADER_STATS
+			m_stats.recordRead(sizeof(T) * count, Order == std::endian::big);
+#endif
+			_readBackend(dst, sizeof(T) * count);
+			Simd::toNativeArray<Order>(dst, count);
+		}
+
+		template <std::endian Order>
+		void
+		_readHalfArrayIn(float* dst, size_t count)
+		{
+			// Raw halfs are read into the upper half of `dst`, then widened in place front to back
+			uint16_t* raw = (uint16_t*)dst + count;
+			_readArrayIn<Order>(raw, count);
+			Simd::halfToFloatArray(raw, dst, count);
+		}
+
+		// Float arrays as stored: `Stored` is uint16_t for halfs
+		template <typename Stored, std::endian Order, typename T>
+		void
+		_readFloatArrayIn(T* dst, size_t count)
+		{
+			if constexpr (std::is_same_v<Stored, uint16_t>)
+				_readHalfArrayIn<Order>(dst, count);
+			else
+				_readArrayIn<Order>(dst, count);
+		}
+
+		// Cursor moves that are part of a read (rewinds, skipping decoded bytes) are not seeks
+		void
+		_seekQuiet(std::streamoff offset, std::ios_base::seekdir way)
+		{
+#ifdef BINARYREADER_STATS
+			m_statsMuted = true;
+			try
+			{
+				_self().seek(offset, way);
+			}
+			catch (...)
+			{
+				m_statsMuted = false;
+				throw;
+			}
+			m_statsMuted = false;
+#else
+			_self().seek(offset, way);
+#endif
+		}
+
+		void
+		_statConsumed([[maybe_unused]] size_t count)
+		{
+#ifdef BINARYREADER_STATS
+			m_stats.bytesDecodedInPlace += count;
+#endif
+		}
+
+		template <typename Exception>
+		Exception
+		_statFailure(Exception&& e)
+		{
+#ifdef BINARYREADER_STATS
+			m_stats.safeFailures++;
+#endif
+			return std::move(e);
+		}
+
+		// Bulk array reads consume the whole array up front
+		// On failure, rewind so the cursor sits just past the offending element like an element-wise read
+		template <typename T>
+		void
+		_unreadAfter(size_t count, size_t failedIndex)
+		{
+			_seekQuiet(-(std::streamoff)((count - failedIndex - 1) * sizeof(T)), std::ios::cur);
+		}
+
+		// ULEB arrays are checked as they are decoded, a memory view or a single value at a time
+		// `find(values, n)` returns the first bad one of `n` values just decoded, or n
+		// Decoding stops there with the cursor just past the bad value; returns its index, or `count`
+		template <typename Find>
+		size_t
+		_readULEBArrayUntil(uint64_t* dst, size_t count, int maxBits, Find&& find)
+		{
+			size_t done = 0;
+			while (done < count)
+			{
+				size_t remaining = 0;
+				const uint8_t* src = _self().cursorPtr(remaining);
+				if (src == nullptr)
+				{
+					for (; done < count; done++)
+					{
+						dst[done] = _readULEB(maxBits);
+						if (find(dst + done, 1) == 0)
+							return done;
+					}
+					return count;
+				}
+
+				size_t decoded = 0;
+				size_t used = Leb::decodeULEBArray(src, remaining, dst + done, count - done, decoded, maxBits);
+				size_t bad = find(dst + done, decoded);
+				bool failed = bad < decoded;
+				// Only the bytes up to the bad value are consumed. Its offset is found by decoding the
+				//   view again up to it, which can't fail
+				if (failed)
+					used = Leb::decodeULEBArray(src, remaining, dst + done, bad + 1, decoded, maxBits);
+				_statConsumed(used);
+				_seekQuiet(used, std::ios::cur);
+				if (failed)
+					return done + bad;
+				done += decoded;
+
+				// The next value straddles the end of the memory view
+				if (done < count)
+				{
+					dst[done] = _readULEB(maxBits);
+					if (find(dst + done, 1) == 0)
+						return done;
+					done++;
+				}
+			}
+			return count;
+		}
+
+		// Whole `Stored` elements of `count` that are still in the data
+		// Memory readers answer from the cursor, so the length is only asked for near the end
+		template <typename Stored>
+		size_t
+		_elementsLeft(size_t count)
+		{
+			size_t remaining = 0;
+			if (_self().cursorPtr(remaining) && remaining / sizeof(Stored) >= count)
+				return count;
+			return std::min(count, _available() / sizeof(Stored));
+		}
+
+		// Safe arrays are read in bulk and then checked, but an element-wise read reports a bad element before
+		//   it runs out of data. So the part of the array that is in the data is read and checked first, and only
+		//   then the rest, which fails however the reader fails at its end
+		// `readPart(start, n)` reads and checks elements [start, start + n) and returns the first bad one, or start + n
+		// Returns the bad element, with the cursor just after it, or `count`
+		template <typename Stored, typename ReadPart>
+		size_t
+		_readInParts(size_t count, ReadPart&& readPart)
+		{
+			size_t present = _elementsLeft<Stored>(count);
+			size_t start = 0;
+			for (size_t n : { present, count - present })
+			{
+				if (n == 0)
+					continue;
+				size_t i = readPart(start, n);
+				if (i < start + n)
+				{
+					_unreadAfter<Stored>(start + n, i);
+					return i;
+				}
+				start += n;
+			}
+			return count;
+		}
+
+		// Vectorized pass over each part; only a failing block is rescanned element-wise
+		template <std::endian Order, typename T>
+		size_t
+		_readArrayInRange(T* dst, size_t count, T min, T max)
+		{
+			return _readInParts<T>(count, [&](size_t start, size_t n) {
+				_readArrayIn<Order>(dst + start, n);
+				return start + Simd::findOutOfRange(dst + start, n, min, max);
+			});
+		}
+
+		template <std::endian Order, typename T>
+		size_t
+		_readArrayEqual(T* dst, size_t count, T exact)
+		{
+			return _readInParts<T>(count, [&](size_t start, size_t n) {
+				_readArrayIn<Order>(dst + start, n);
+				return start + Simd::findNotEqual(dst + start, n, exact);
+			});
+		}
+
+		template <std::endian Order, typename T>
+		void
+		_readCheckedArray(T* dst, size_t count, T min, T max, const DebugMessage& debugMsg)
+		{
+			size_t i = _readArrayInRange<Order>(dst, count, min, max);
+			if (i == count)
+				return;
+
+			if (dst[i] < min)
+				throw _statFailure(LimitException(dst[i], min, i, debugMsg));
+			else
+				throw _statFailure(LimitException(dst[i], max, i, debugMsg));
+		}
+
+		template <std::endian Order, typename T>
+		void
+		_readCheckedArray(T* dst, size_t count, T exact, const DebugMessage& debugMsg)
+		{
+			size_t i = _readArrayEqual<Order>(dst, count, exact);
+			if (i == count)
+				return;
+
+			throw _statFailure(LimitException(dst[i], exact, i, debugMsg));
+		}
+
+		template <typename T>
+		static ReadError<T>
+		_rangeError(T value, T min, T max, size_t index)
+		{
+			if (value < min)
+				return { ReadErrorKind::BelowMin, index, value, min };
+			return { ReadErrorKind::AboveMax, index, value, max };
+		}
+
+#ifdef BINARYREADER_HAS_EXPECTED
+		// Non-throwing versions of _readCheckedArray
+		template <std::endian Order, typename T>
+		ReadResult<T, void>
+		_tryReadArray(T* dst, size_t count, T min, T max)
+		{
+			size_t i = _readArrayInRange<Order>(dst, count, min, max);
+			if (i == count)
+				return {};
+			return std::unexpected(_statFailure(_rangeError(dst[i], min, max, i)));
+		}
+
+		template <std::endian Order, typename T>
+		ReadResult<T, void>
+		_tryReadArray(T* dst, size_t count, T exact)
+		{
+			size_t i = _readArrayEqual<Order>(dst, count, exact);
+			if (i == count)
+				return {};
+			return std::unexpected(_statFailure(ReadError<T>{ ReadErrorKind::NotExact, i, dst[i], exact }));
+		}
+
+		// Reads, validates and fixes up a float array in place. `Stored` is the element type in the data
+		template <typename Stored, std::endian Order, typename T>
+		ReadResult<T, void>
+		_tryReadFloatArray(T* dst, size_t count, T min, T max, uint8_t flags)
+		{
+			ReadError<T> error;
+			if (!_readValidFloatArray<Stored, Order>(dst, count, min, max, flags, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return {};
+		}
+
+		template <typename Stored, std::endian Order, typename T>
+		ReadResult<T, void>
+		_tryReadFloatArray(T* dst, size_t count, T exact, uint8_t flags)
+		{
+			ReadError<T> error;
+			if (!_readValidFloatArray<Stored, Order>(dst, count, exact, flags, error))
+				return std::unexpected(_statFailure(std::move(error)));
+			return {};
+		}
+#endif
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Utils
+
+		// Up to 9 bytes are needed when the bit offset is non-zero
+		// The buffer is local so concurrent readers never share it
+		uint64_t
+		_readBitField(int bitCount, int byteCount)
+		{
+			uint8_t buf[16] = {};
+			_readBytes(buf, byteCount);
+
+			uint64_t low;
+			std::memcpy(&low, buf, sizeof(uint64_t));
+			if constexpr (std::endian::native == std::endian::big)
+				low = Simd::bswap64(low);
+
+			uint64_t ret = low >> m_bitOffset;
+			if (m_bitOffset > 0)
+				ret |= (uint64_t)buf[8] << (64 - m_bitOffset);
+			return ret & Bits::lowMask(bitCount);
+		}
+
+		// Unsigned
+		template <typename T>
+		requires std::unsigned_integral<T>
+		T
+		_readBitwiseScalar(int bitCount, int byteCount)
+		{
+			return (T)_readBitField(bitCount, byteCount);
+		}
+
+		// Signed
+		template <typename T>
+		requires std::signed_integral<T>
+		T
+		_readBitwiseScalar(int bitCount, int byteCount)
+		{
+			// Convert signed integer of width `bitCount` to width `sizeof(T)`
+			return (T)Bits::signExtend(_readBitField(bitCount, byteCount), bitCount);
+		}
+
+		// Applies the CONV_* flags. Returns false with `error` filled in if the value is rejected
+		template <typename T>
+		requires std::floating_point<T>
+		bool
+		_convertFloat(T data, uint8_t flags, T& fixed, ReadError<T>& error)
+		{
+			fixed = data;
+
+			switch(std::fpclassify(data))
+			{
+				case FP_INFINITE:
+				{
+					if (flags & CONV_INF)
+					{
+						if (data == std::numeric_limits<T>::infinity())
+						{
+							const static T floatMax = std::numeric_limits<T>::max();
+							std::memcpy(&fixed, &floatMax, sizeof(T));
+						}
+						else
+						{
+							const static T floatMin = -std::numeric_limits<T>::max();
+							std::memcpy(&fixed, &floatMin, sizeof(T));
+						}
+					}
+					else
+					{
+						error = { ReadErrorKind::Infinite, 0, data, 0 };
+						return false;
+					}
+					break;
+				}
+				case FP_NAN:
+				{
+					error = { ReadErrorKind::NaN, 0, data, 0 };
+					return false;
+				}
+				case FP_ZERO:
+				{
+					if (flags & CONV_ZERO)
+						fixed = 0;
+					break;
+				}
+				case FP_SUBNORMAL:
+				{
+					if (flags & FAIL_SUBNORM)
+					{
+						error = { ReadErrorKind::Subnormal, 0, data, 0 };
+						return false;
+					}
+					break;
+				}
+				case FP_NORMAL:
+				default:
+					break;
+			}
+
+			return true;
+		}
+
+		template <typename T>
+		requires std::floating_point<T>
+		bool
+		_validateFloat(T data, T min, T max, uint8_t flags, T& fixed, ReadError<T>& error)
+		{
+			if (!_convertFloat(data, flags, fixed, error))
+				return false;
+
+			// Compared in ULP order, see Simd::floatKey
+			auto key = Simd::floatKey(fixed);
+			if (key < Simd::floatKey(min))
+				error = { ReadErrorKind::BelowMin, 0, data, min };
+			else if (key >= Simd::floatKey(max))
+				error = { ReadErrorKind::AboveMax, 0, data, max };
+			else
+				return true;
+			return false;
+		}
+
+		template <typename T>
+		requires std::floating_point<T>
+		bool
+		_validateFloat(T data, T exact, uint8_t flags, T& fixed, ReadError<T>& error)
+		{
+			if (!_convertFloat(data, flags, fixed, error))
+				return false;
+
+			if (Simd::floatKey(fixed) != Simd::floatKey(exact))
+			{
+				error = { ReadErrorKind::NotExact, 0, data, exact };
+				return false;
+			}
+			return true;
+		}
+
+		// The exception the Safe float reads have always thrown for each kind of failure
+		template <typename T>
+		[[noreturn]] void
+		_throwFloatError(const ReadError<T>& error, const DebugMessage& debugMsg)
+		{
+			switch (error.kind)
+			{
+			case ReadErrorKind::NaN:
+			case ReadErrorKind::Subnormal:
+				throw _statFailure(NonNormalFloatException(error.value, debugMsg));
+			default:
+				throw _statFailure(LimitException(error.value, error.limit, debugMsg));
+			}
+		}
+
+		template <typename T>
+		requires std::floating_point<T>
+		T
+		_checkFloat(T data, T min, T max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			T fixed;
+			ReadError<T> error;
+			if (!_validateFloat(data, min, max, flags, fixed, error))
+				_throwFloatError(error, debugMsg);
+			return fixed;
+		}
+
+		template <typename T>
+		requires std::floating_point<T>
+		T
+		_checkFloat(T data, T exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			T fixed;
+			ReadError<T> error;
+			if (!_validateFloat(data, exact, flags, fixed, error))
+				_throwFloatError(error, debugMsg);
+			return fixed;
+		}
+
+		// Float arrays are checked by Simd::fixFloats, which stops at the first failing element
+		// From there the scalar checks take over, to report that element
+		// Read in parts like the integer arrays, see _readInParts
+		// On failure the cursor is left just after that element, `error.index` is set, and false returned
+		template <typename Stored, std::endian Order, typename T, typename Validate>
+		bool
+		_readValidFloatArray(T* dst, size_t count, Simd::FloatKey<T> keyMin, Simd::FloatKey<T> keyMax, uint8_t flags,
+			Validate&& validate, ReadError<T>& error)
+		{
+			size_t i = _readInParts<Stored>(count, [&](size_t start, size_t n) {
+				T* part = dst + start;
+				_readFloatArrayIn<Stored, Order>(part, n);
+				size_t j = Simd::fixFloats(part, n, keyMin, keyMax, flags & CONV_INF, flags & CONV_ZERO, flags & FAIL_SUBNORM);
+				while (j < n && validate(part[j], part[j], error))
+					j++;
+				return start + j;
+			});
+			if (i == count)
+				return true;
+			error.index = i;
+			return false;
+		}
+
+		template <typename Stored, std::endian Order, typename T>
+		requires std::floating_point<T>
+		bool
+		_readValidFloatArray(T* dst, size_t count, T min, T max, uint8_t flags, ReadError<T>& error)
+		{
+			return _readValidFloatArray<Stored, Order>(dst, count, Simd::floatKey(min), Simd::floatKey(max), flags,
+				[&](T data, T& fixed, ReadError<T>& e) { return _validateFloat(data, min, max, flags, fixed, e); }, error);
+		}
+
+		template <typename Stored, std::endian Order, typename T>
+		requires std::floating_point<T>
+		bool
+		_readValidFloatArray(T* dst, size_t count, T exact, uint8_t flags, ReadError<T>& error)
+		{
+			// [exact, exact + 1 ULP). The largest key is a NaN, which never passes anyway
+			auto key = Simd::floatKey(exact);
+			auto keyEnd = key == std::numeric_limits<decltype(key)>::max() ? key : key + 1;
+			return _readValidFloatArray<Stored, Order>(dst, count, key, keyEnd, flags,
+				[&](T data, T& fixed, ReadError<T>& e) { return _validateFloat(data, exact, flags, fixed, e); }, error);
+		}
+
+		template <typename Stored, std::endian Order, typename T>
+		requires std::floating_point<T>
+		void
+		_readCheckedFloatArray(T* dst, size_t count, T min, T max, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			ReadError<T> error;
+			if (!_readValidFloatArray<Stored, Order>(dst, count, min, max, flags, error))
+				_throwFloatError(error, debugMsg);
+		}
+
+		template <typename Stored, std::endian Order, typename T>
+		requires std::floating_point<T>
+		void
+		_readCheckedFloatArray(T* dst, size_t count, T exact, uint8_t flags, const DebugMessage& debugMsg)
+		{
+			ReadError<T> error;
+			if (!_readValidFloatArray<Stored, Order>(dst, count, exact, flags, error))
+				_throwFloatError(error, debugMsg);
+		}
+
+		// https://github.com/yretenai/Lotus/blob/500c5d615563467a87bd002df70b789e944c3240/Lotus.Struct/CursoredMemoryMarshal.cs#L125C31-L125C38
+		uint64_t
+		_readULEB(int maxBits = 64)
+		{
+			uint64_t result = 0;
+			
+			uint8_t curByte;
+			for (int curShift = 0; curShift < maxBits - 1; curShift += 7)
+			{
+				curByte = readScalar<uint8_t>();
+				result |= (curByte & 0x7Ful) << curShift;
+
+				if (curByte <= 0x7ful)
+					return result;
+			}
+
+			curByte = readScalar<uint8_t>();
+			result |= (uint64_t)curByte << (maxBits - 1);
+			return result;
+		}
+
+		int64_t
+		_readSLEB(int maxBits = 64)
+		{
+			uint64_t result = 0;
+			int shift = 0;
+
+			uint8_t curByte;
+			do
+			{
+				curByte = readScalar<uint8_t>();
+				if (shift < 64)
+					result |= (curByte & 0x7Ful) << shift;
+				shift += 7;
+			} while ((curByte & 0x80) && shift < maxBits);
+
+			// Sign-extend from the top bit of the last group
+			if (shift < 64 && (curByte & 0x40))
+				result |= ~0ull << shift;
+
+			return (int64_t)result;
+		}
+
+		// I saved this from somewhere online
+		// If I remembered where, I would give credit
+		template <std::endian Order = std::endian::little>
+		float
+		_readHalfFloat()
+		{
+			int hbits = _readScalarIn<uint16_t, Order>();
+			int mant = hbits & 0x03ff;            // 10 bits mantissa
+			int exp = hbits & 0x7c00;            // 5 bits exponent
+			if (exp == 0x7c00)                   // NaN/Inf
+				exp = 0x3fc00;                    // -> NaN/Inf
+			else if (exp != 0)                   // normalized value
+			{
+				exp += 0x1c000;                   // exp - 15 + 127
+				if (mant == 0 && exp > 0x1c400)  // smooth transition
+				{
+					uint32_t t = ((hbits & 0x8000) << 16) | (exp << 13);
+					float ret;
+					std::memcpy(&ret, &t, 4);
+					return ret;
+				}
+			}
+			else if (mant != 0)                  // && exp==0 -> subnormal
+			{
+				exp = 0x1c400;                    // make it normal
+				do
+				{
+					mant <<= 1;                   // mantissa * 2
+					exp -= 0x400;                 // decrease exp by 1
+				} while ((mant & 0x400) == 0); // while not normal
+				mant &= 0x3ff;                    // discard subnormal bit
+			}                                     // else +/-0 -> +/-0
+			uint32_t t(                      // combine all parts
+				((hbits & 0x8000) << 16)         // sign  << ( 31 - 15 )
+				| ((exp | mant) << 13));         // value << ( 23 - 10 )
+			float ret;
+			std::memcpy(&ret, &t, 4);
+			return ret;
+		}
+	};
+};
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "BinaryReaderSimd.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <concepts>
+#include <ios>
+#include <stdexcept>
+
+namespace BinaryReader
+{
+	namespace Bits
+	{
+		inline uint64_t
+		lowMask(int bitCount)
+		{
+			return bitCount >= 64 ? ~0ull : (1ull << bitCount) - 1;
+		}
+
+		// Treats bit `bitCount - 1` of `raw` as the sign bit
+		inline uint64_t
+		signExtend(uint64_t raw, int bitCount)
+		{
+			if (bitCount < 64 && ((raw >> (bitCount - 1)) & 1))
+				raw |= ~0ull << bitCount;
+			return raw;
+		}
+	};
+
+	// Bit-stream reader over any BinaryReader/BasicReader
+	// Bits are consumed least-significant first, the same order as readBitwiseScalar
+	// Holds up to 64 bits in an accumulator, and only touches the reader when it refills.
+	//   On memory-backed readers a refill is a single unaligned 8-byte load
+	// The underlying reader's cursor runs ahead of the bit position until sync() (or destruction)
+	//   moves it back to the exact byte and bit offset, so tell/tellBit stay consistent
+	// The destructor swallows errors from that final sync, so call sync() yourself to see them
+	template <class Reader>
+	class BitReader
+	{
+		Reader& m_reader;
+		uint64_t m_acc;
+		int m_accBits;
+		// Byte offset of the next byte the accumulator will load
+		size_t m_bytePos;
+		// Where the reader's cursor is. Refills only seek when it differs from m_bytePos
+		size_t m_cursorPos;
+		size_t m_length;
+
+	public:
+		explicit BitReader(Reader& reader)
+			: m_reader(reader), m_acc(0), m_accBits(0), m_bytePos(reader.tell()), m_cursorPos(m_bytePos), m_length(reader.getLength())
+		{
+			// Pick up the reader's current bit offset
+			int startBit = reader.tellBit();
+			if (startBit > 0)
+				skipBits(startBit);
+		}
+
+		BitReader(const BitReader&) = delete;
+		BitReader& operator=(const BitReader&) = delete;
+
+		// May run while unwinding from a failed read, where a throwing sync would terminate
+		~BitReader()
+		{
+			try
+			{
+				sync();
+			}
+			catch (...)
+			{
+			}
+		}
+
+		// Up to 56 bits are guaranteed after one refill
+		uint64_t
+		peekBits(int bitCount)
+		{
+			if (bitCount <= 0 || bitCount > 56)
+				throw std::invalid_argument("Peek bits must be between 1 and 56");
+			if (m_accBits < bitCount)
+				_refill(bitCount);
+			return m_acc & Bits::lowMask(bitCount);
+		}
+
+		uint64_t
+		readBits(int bitCount)
+		{
+			if (bitCount <= 0 || bitCount > 64)
+				throw std::invalid_argument("Read bits must be between 1 and 64");
+
+			if (bitCount > 56)
+			{
+				uint64_t low = _take(32);
+				return low | (_take(bitCount - 32) << 32);
+			}
+			return _take(bitCount);
+		}
+
+		void
+		skipBits(size_t bitCount)
+		{
+			if (bitCount <= (size_t)m_accBits)
+			{
+				_drop((int)bitCount);
+				return;
+			}
+
+			// Skip whole bytes without loading them
+			bitCount -= m_accBits;
+			m_acc = 0;
+			m_accBits = 0;
+			m_bytePos += bitCount / 8;
+			if (bitCount % 8 > 0)
+				_take((int)(bitCount % 8));
+		}
+
+		// Same sign handling as BasicReader::readBitwiseScalar
+		template <typename T>
+		requires std::integral<T>
+		T
+		readBitwise(int bitCount)
+		{
+			uint64_t raw = readBits(bitCount);
+			if constexpr (std::signed_integral<T>)
+				raw = Bits::signExtend(raw, bitCount);
+			return (T)raw;
+		}
+
+		template <typename T>
+		requires std::integral<T>
+		void
+		readBitwiseArray(int bitCount, size_t count, T* dst)
+		{
+			if (bitCount <= 0 || bitCount > 64)
+				throw std::invalid_argument("Read bits must be between 1 and 64");
+
+			if (bitCount > 56)
+			{
+				for (size_t i = 0; i < count; i++)
+					dst[i] = readBitwise<T>(bitCount);
+				return;
+			}
+
+			const uint64_t mask = Bits::lowMask(bitCount);
+			for (size_t i = 0; i < count; i++)
+			{
+				if (m_accBits < bitCount)
+					_refill(bitCount);
+
+				uint64_t raw = m_acc & mask;
+				_drop(bitCount);
+				if constexpr (std::signed_integral<T>)
+					raw = Bits::signExtend(raw, bitCount);
+				dst[i] = (T)raw;
+			}
+		}
+
+		// Byte holding the next unread bit
+		size_t
+		tell() const
+		{
+			return (m_bytePos * 8 - m_accBits) / 8;
+		}
+
+		int
+		tellBit() const
+		{
+			return (int)((m_bytePos * 8 - m_accBits) % 8);
+		}
+
+		// Moves the reader to exactly the next unread bit
+		void
+		sync()
+		{
+			m_cursorPos = tell();
+			m_reader._seekQuiet(m_cursorPos, std::ios::beg);
+			m_reader.seekBit(tellBit(), std::ios::beg);
+		}
+
+	private:
+		uint64_t
+		_take(int bitCount)
+		{
+			if (m_accBits < bitCount)
+				_refill(bitCount);
+			uint64_t ret = m_acc & Bits::lowMask(bitCount);
+			_drop(bitCount);
+			return ret;
+		}
+
+		void
+		_drop(int bitCount)
+		{
+			m_acc = bitCount >= 64 ? 0 : m_acc >> bitCount;
+			m_accBits -= bitCount;
+		}
+
+		// Tops the accumulator up to at least 56 bits (fewer at end of stream)
+		void
+		_refill(int needed)
+		{
+			size_t wantBytes = (size_t)(64 - m_accBits) / 8;
+			size_t available = m_bytePos < m_length ? m_length - m_bytePos : 0;
+			size_t loadBytes = wantBytes < available ? wantBytes : available;
+
+			uint64_t word = 0;
+			// Sequential refills find the cursor where the last one left it. Seeking anyway would
+			//   throw away BinaryReaderFile's stream buffer on every refill
+			if (m_cursorPos != m_bytePos)
+			{
+				m_reader._seekQuiet(m_bytePos, std::ios::beg);
+				m_cursorPos = m_bytePos;
+			}
+
+			size_t viewBytes = 0;
+			const uint8_t* view = m_reader.cursorData(viewBytes);
+			if (view != nullptr && viewBytes >= sizeof(uint64_t))
+			{
+				// Loaded in place, so the cursor stays put
+				std::memcpy(&word, view, sizeof(uint64_t));
+				m_reader._statConsumed(loadBytes);
+			}
+			else
+			{
+				m_reader.template readScalarArray<uint8_t>((uint8_t*)&word, loadBytes);
+				m_cursorPos += loadBytes;
+			}
+
+			if constexpr (std::endian::native == std::endian::big)
+				word = Simd::bswap64(word);
+
+			word &= Bits::lowMask((int)loadBytes * 8);
+			m_acc |= word << m_accBits;
+			m_accBits += (int)loadBytes * 8;
+			m_bytePos += loadBytes;
+
+			if (m_accBits < needed)
+				throw std::runtime_error("Read past end of bit stream");
+		}
+	};
+};
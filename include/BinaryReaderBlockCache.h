@@ -0,0 +1,512 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// MinGW has both headers, but its struct stat has no nanosecond mtime
+#if !defined(_WIN32) && __has_include(<sys/stat.h>) && __has_include(<unistd.h>)
+	#include <sys/stat.h>
+	#define BINARYREADER_HAS_FSTAT 1
+#endif
+
+namespace BinaryReader
+{
+	struct BlockCacheStats
+	{
+		// Lookups served from the cache, and those that had to load the block
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		// Blocks dropped by CLOCK to make room
+		uint64_t evictions = 0;
+		// Blocks currently cached
+		size_t blocks = 0;
+	};
+
+	// Fixed-size file blocks shared by every reader that uses the cache, keyed by (file id, block index)
+	// A file id names one version of a file: a new size or modification time gets a new id, and the old id's blocks are dropped
+	// Readers hold their id through a FileLease. An id is forgotten once no reader holds it and none of its blocks
+	//   are cached, so the file table stays as small as the readers and blocks alive
+	// Split into shards, each with its own lock and CLOCK ring, so threads reading different blocks rarely contend
+	// The memory budget counts cached blocks. A block evicted while a reader still points into it
+	//   lives on until that reader moves to another block
+	// Thread-safe. Use one per process (shared()) so separate readers of the same file share blocks
+	class BlockCache
+	{
+	public:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]> data;
+			// Less than the block size only for the last block of a file
+			size_t size;
+		};
+
+		// One reader's hold on a file id, from acquireFile. Releases the id when destroyed
+		class FileLease
+		{
+			BlockCache* m_cache;
+			uint64_t m_id;
+
+		public:
+			FileLease()
+				: m_cache(nullptr), m_id(0)
+			{
+			}
+
+			FileLease(BlockCache& cache, uint64_t id)
+				: m_cache(&cache), m_id(id)
+			{
+			}
+
+			FileLease(FileLease&& other) noexcept
+				: m_cache(std::exchange(other.m_cache, nullptr)), m_id(other.m_id)
+			{
+			}
+
+			FileLease&
+			operator=(FileLease&& other) noexcept
+			{
+				if (this != &other)
+				{
+					_release();
+					m_cache = std::exchange(other.m_cache, nullptr);
+					m_id = other.m_id;
+				}
+				return *this;
+			}
+
+			~FileLease()
+			{
+				_release();
+			}
+
+			uint64_t
+			id() const
+			{
+				return m_id;
+			}
+
+		private:
+			void
+			_release()
+			{
+				if (m_cache != nullptr)
+					m_cache->_releaseFile(m_id);
+				m_cache = nullptr;
+			}
+		};
+
+	private:
+		struct Key
+		{
+			uint64_t file;
+			uint64_t block;
+
+			bool
+			operator==(const Key&) const = default;
+		};
+
+		struct KeyHash
+		{
+			size_t
+			operator()(const Key& key) const
+			{
+				return (size_t)((key.file * 0x9E3779B97F4A7C15ull) ^ key.block);
+			}
+		};
+
+		// What a file looked like when its id was handed out
+		struct FileVersion
+		{
+			uint64_t size;
+			int64_t mtime;
+			uint64_t id;
+		};
+
+		// Who still needs an id: leases held by readers, and blocks cached under it
+		struct FileUse
+		{
+			std::pair<uint64_t, uint64_t> file;
+			size_t leases;
+			size_t blocks;
+		};
+
+		struct Slot
+		{
+			Key key;
+			std::shared_ptr<const Block> block;
+			// Set on every hit, cleared as the CLOCK hand passes
+			bool referenced;
+		};
+
+		struct alignas(64) Shard
+		{
+			std::mutex lock;
+			std::unordered_map<Key, size_t, KeyHash> index;
+			std::vector<Slot> slots;
+			size_t hand = 0;
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t evictions = 0;
+		};
+
+		size_t m_blockSize;
+		size_t m_budget;
+		size_t m_shardCapacity;
+		std::unique_ptr<Shard[]> m_shards;
+		size_t m_shardCount;
+
+		// Taken after a shard's lock, never before
+		std::mutex m_filesLock;
+		// The current version of each file, keyed by (device, inode)
+		std::map<std::pair<uint64_t, uint64_t>, FileVersion> m_files;
+		// Every id still in use, including the old versions of files that were rewritten
+		std::unordered_map<uint64_t, FileUse> m_uses;
+		// Ids only ever count up, so one is never reused for another file, even after clear()
+		uint64_t m_nextId;
+
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+		static constexpr size_t DEFAULT_BUDGET = 256 * 1024 * 1024;
+		static constexpr size_t DEFAULT_SHARDS = 16;
+
+		// Every shard holds at least one block, so very small budgets are rounded up
+		explicit BlockCache(size_t budget = DEFAULT_BUDGET, size_t blockSize = DEFAULT_BLOCK_SIZE, size_t shards = DEFAULT_SHARDS)
+			: m_blockSize(std::max<size_t>(blockSize, 1)), m_budget(budget), m_shardCapacity(0), m_shards(),
+			  m_shardCount(std::max<size_t>(shards, 1)), m_filesLock(), m_files(), m_uses(), m_nextId(0)
+		{
+			m_shardCapacity = std::max<size_t>(1, budget / m_blockSize / m_shardCount);
+			m_shards = std::make_unique<Shard[]>(m_shardCount);
+		}
+
+		BlockCache(const BlockCache&) = delete;
+		BlockCache& operator=(const BlockCache&) = delete;
+
+		static BlockCache&
+		shared()
+		{
+			static BlockCache cache;
+			return cache;
+		}
+
+		// Leases the id of a file, the same for every reader that opened it while it had this size and modification time
+		// `device`, `inode`, `size` and `mtime` (in ns) come from fstat. When the size or time differ from the last call
+		//   for the same file, it was truncated or rewritten: it gets a new id and the blocks cached under the old one are dropped
+		// The id stays valid while the lease is held; readers keep theirs for as long as they read through the cache
+		FileLease
+		acquireFile(uint64_t device, uint64_t inode, uint64_t size, int64_t mtime)
+		{
+			std::pair<uint64_t, uint64_t> file{ device, inode };
+			uint64_t stale;
+			uint64_t id;
+			{
+				std::lock_guard<std::mutex> guard(m_filesLock);
+				auto it = m_files.find(file);
+				if (it != m_files.end() && it->second.size == size && it->second.mtime == mtime)
+				{
+					m_uses[it->second.id].leases++;
+					return FileLease(*this, it->second.id);
+				}
+
+				id = m_nextId++;
+				m_uses.emplace(id, FileUse{ file, 1, 0 });
+				if (it == m_files.end())
+				{
+					m_files.emplace(file, FileVersion{ size, mtime, id });
+					return FileLease(*this, id);
+				}
+				stale = it->second.id;
+				it->second = FileVersion{ size, mtime, id };
+			}
+			_dropFile(stale);
+			return FileLease(*this, id);
+		}
+
+#ifdef BINARYREADER_HAS_FSTAT
+		FileLease
+		acquireFile(const struct stat& fileStat)
+		{
+			return acquireFile((uint64_t)fileStat.st_dev, (uint64_t)fileStat.st_ino, (uint64_t)fileStat.st_size, modifiedNs(fileStat));
+		}
+
+		static int64_t
+		modifiedNs(const struct stat& fileStat)
+		{
+#ifdef __APPLE__
+			const struct timespec& mtime = fileStat.st_mtimespec;
+#else
+			const struct timespec& mtime = fileStat.st_mtim;
+#endif
+			return (int64_t)mtime.tv_sec * 1000000000 + mtime.tv_nsec;
+		}
+#endif
+
+		// Files with an id still in use
+		size_t
+		fileCount()
+		{
+			std::lock_guard<std::mutex> guard(m_filesLock);
+			return m_uses.size();
+		}
+
+		// Returns block `block` of file `file`. On a miss, fill(dst, blockSize) loads it and returns how many bytes it wrote
+		// The load runs without holding the shard's lock; if two threads miss on one block, the first to finish is kept
+		template <typename Fill>
+		std::shared_ptr<const Block>
+		get(uint64_t file, uint64_t block, Fill&& fill)
+		{
+			Key key{ file, block };
+			Shard& shard = _shard(key);
+			{
+				std::lock_guard<std::mutex> guard(shard.lock);
+				auto it = shard.index.find(key);
+				if (it != shard.index.end())
+				{
+					shard.hits++;
+					Slot& slot = shard.slots[it->second];
+					slot.referenced = true;
+					return slot.block;
+				}
+				shard.misses++;
+			}
+
+			auto loaded = std::make_shared<Block>();
+			loaded->data = std::make_unique_for_overwrite<uint8_t[]>(m_blockSize);
+			loaded->size = fill(loaded->data.get(), m_blockSize);
+
+			std::lock_guard<std::mutex> guard(shard.lock);
+			auto it = shard.index.find(key);
+			if (it != shard.index.end())
+				return shard.slots[it->second].block;
+
+			size_t slot;
+			if (shard.slots.size() < m_shardCapacity)
+			{
+				slot = shard.slots.size();
+				shard.slots.push_back(Slot{ key, loaded, false });
+				_blockAdded(file, nullptr);
+			}
+			else
+			{
+				slot = _evict(shard);
+				_blockAdded(file, &shard.slots[slot].key.file);
+				shard.slots[slot] = Slot{ key, loaded, false };
+			}
+			shard.index.emplace(key, slot);
+			return loaded;
+		}
+
+		// Copies `count` bytes of file `file` from `offset`, block by block
+		// Misses are loaded with fill(dst, blockSize, blockIndex), which returns how many bytes it wrote. Throws if the file ends first
+		template <typename Fill>
+		void
+		read(uint64_t file, void* dst, size_t count, size_t offset, Fill&& fill)
+		{
+			uint8_t* out = (uint8_t*)dst;
+			while (count > 0)
+			{
+				uint64_t index = offset / m_blockSize;
+				size_t inBlock = offset % m_blockSize;
+				std::shared_ptr<const Block> block = get(file, index, [&](uint8_t* blockDst, size_t size) {
+					return fill(blockDst, size, index);
+				});
+				if (block->size <= inBlock)
+					throw std::runtime_error("Failed to read file");
+				size_t take = std::min(count, block->size - inBlock);
+				std::memcpy(out, block->data.get() + inBlock, take);
+				out += take;
+				offset += take;
+				count -= take;
+			}
+		}
+
+		BlockCacheStats
+		stats()
+		{
+			BlockCacheStats ret;
+			for (size_t i = 0; i < m_shardCount; i++)
+			{
+				Shard& shard = m_shards[i];
+				std::lock_guard<std::mutex> guard(shard.lock);
+				ret.hits += shard.hits;
+				ret.misses += shard.misses;
+				ret.evictions += shard.evictions;
+				ret.blocks += shard.slots.size();
+			}
+			return ret;
+		}
+
+		void
+		resetStats()
+		{
+			for (size_t i = 0; i < m_shardCount; i++)
+			{
+				Shard& shard = m_shards[i];
+				std::lock_guard<std::mutex> guard(shard.lock);
+				shard.hits = 0;
+				shard.misses = 0;
+				shard.evictions = 0;
+			}
+		}
+
+		// Drops every block and forgets every file. Readers opened earlier keep working, but no longer share blocks
+		//   with readers opened afterwards
+		void
+		clear()
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_filesLock);
+				m_files.clear();
+			}
+			for (size_t i = 0; i < m_shardCount; i++)
+			{
+				Shard& shard = m_shards[i];
+				std::lock_guard<std::mutex> guard(shard.lock);
+				shard.index.clear();
+				shard.slots.clear();
+				shard.hand = 0;
+			}
+
+			// Only the ids readers still hold are left
+			std::lock_guard<std::mutex> guard(m_filesLock);
+			for (auto it = m_uses.begin(); it != m_uses.end();)
+			{
+				it->second.blocks = 0;
+				if (it->second.leases == 0)
+					it = m_uses.erase(it);
+				else
+					++it;
+			}
+		}
+
+		size_t
+		blockSize() const
+		{
+			return m_blockSize;
+		}
+
+		size_t
+		budget() const
+		{
+			return m_budget;
+		}
+
+	private:
+		Shard&
+		_shard(const Key& key)
+		{
+			// Fibonacci hashing spreads a file's consecutive blocks over the shards
+			uint64_t mixed = (key.file << 40) ^ key.block;
+			return m_shards[(size_t)((mixed * 0x9E3779B97F4A7C15ull) >> 32) % m_shardCount];
+		}
+
+		// Frees every block of `file`, moving the last slot of the ring into each hole
+		void
+		_dropFile(uint64_t file)
+		{
+			for (size_t i = 0; i < m_shardCount; i++)
+			{
+				Shard& shard = m_shards[i];
+				std::lock_guard<std::mutex> guard(shard.lock);
+				size_t dropped = 0;
+				for (size_t slot = 0; slot < shard.slots.size();)
+				{
+					if (shard.slots[slot].key.file != file)
+					{
+						slot++;
+						continue;
+					}
+					shard.index.erase(shard.slots[slot].key);
+					if (slot != shard.slots.size() - 1)
+					{
+						shard.slots[slot] = std::move(shard.slots.back());
+						shard.index[shard.slots[slot].key] = slot;
+					}
+					shard.slots.pop_back();
+					dropped++;
+				}
+				if (shard.hand >= shard.slots.size())
+					shard.hand = 0;
+				_blocksRemoved(file, dropped);
+			}
+		}
+
+		// A block of `file` was cached, in place of one of `evicted` if given
+		void
+		_blockAdded(uint64_t file, const uint64_t* evicted)
+		{
+			std::lock_guard<std::mutex> guard(m_filesLock);
+			auto it = m_uses.find(file);
+			if (it != m_uses.end())
+				it->second.blocks++;
+			if (evicted == nullptr)
+				return;
+			it = m_uses.find(*evicted);
+			if (it == m_uses.end())
+				return;
+			it->second.blocks -= std::min<size_t>(1, it->second.blocks);
+			_forgetIfUnused(it);
+		}
+
+		void
+		_blocksRemoved(uint64_t file, size_t count)
+		{
+			if (count == 0)
+				return;
+			std::lock_guard<std::mutex> guard(m_filesLock);
+			auto it = m_uses.find(file);
+			if (it == m_uses.end())
+				return;
+			// clear() may have zeroed the count under a block cached concurrently
+			it->second.blocks -= std::min(count, it->second.blocks);
+			_forgetIfUnused(it);
+		}
+
+		void
+		_releaseFile(uint64_t file)
+		{
+			std::lock_guard<std::mutex> guard(m_filesLock);
+			auto it = m_uses.find(file);
+			if (it == m_uses.end())
+				return;
+			it->second.leases--;
+			_forgetIfUnused(it);
+		}
+
+		// With m_filesLock held. The file's entry goes too, unless it has moved on to a newer id
+		void
+		_forgetIfUnused(std::unordered_map<uint64_t, FileUse>::iterator it)
+		{
+			if (it->second.leases != 0 || it->second.blocks != 0)
+				return;
+			auto version = m_files.find(it->second.file);
+			if (version != m_files.end() && version->second.id == it->first)
+				m_files.erase(version);
+			m_uses.erase(it);
+		}
+
+		// Advances the CLOCK hand to the first slot not referenced since its last pass, and frees it
+		size_t
+		_evict(Shard& shard)
+		{
+			while (shard.slots[shard.hand].referenced)
+			{
+				shard.slots[shard.hand].referenced = false;
+				shard.hand = (shard.hand + 1) % shard.slots.size();
+			}
+			size_t victim = shard.hand;
+			shard.hand = (shard.hand + 1) % shard.slots.size();
+			shard.index.erase(shard.slots[victim].key);
+			shard.evictions++;
+			return victim;
+		}
+	};
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+#if __has_include(<zlib.h>)
+	#include <zlib.h>
+	#define BINARYREADER_HAS_ZLIB
+#endif
+
+namespace BinaryReader
+{
+	// Incremental decompressor used by BinaryReaderDecompressed
+	// clone() must snapshot the full decoder state, since it is what seek checkpoints are made of
+	class DecompressionCodec
+	{
+	public:
+		virtual ~DecompressionCodec() = default;
+
+		// Decompresses from `in` into `out`, advancing both and shrinking the sizes by what was used
+		// Returns true once the end of the compressed stream has been reached
+		virtual bool decompress(const uint8_t*& in, size_t& inSize, uint8_t*& out, size_t& outSize) = 0;
+
+		virtual std::unique_ptr<DecompressionCodec> clone() const = 0;
+	};
+
+#ifdef BINARYREADER_HAS_ZLIB
+	enum class ZlibFormat
+	{
+		// zlib or gzip, detected from the header
+		Auto,
+		// Bare deflate with no header
+		Raw
+	};
+
+	class ZlibCodec : public DecompressionCodec
+	{
+		z_stream m_stream;
+
+	public:
+		ZlibCodec(ZlibFormat format = ZlibFormat::Auto)
+			: m_stream()
+		{
+			int windowBits = format == ZlibFormat::Raw ? -MAX_WBITS : MAX_WBITS + 32;
+			if (inflateInit2(&m_stream, windowBits) != Z_OK)
+				throw std::bad_alloc();
+		}
+
+		// Copies the sliding window too, so the copy resumes exactly where this one is
+		ZlibCodec(const ZlibCodec& other)
+			: m_stream()
+		{
+			if (inflateCopy(&m_stream, const_cast<z_stream*>(&other.m_stream)) != Z_OK)
+				throw std::bad_alloc();
+		}
+
+		ZlibCodec& operator=(const ZlibCodec&) = delete;
+
+		~ZlibCodec()
+		{
+			inflateEnd(&m_stream);
+		}
+
+		bool
+		decompress(const uint8_t*& in, size_t& inSize, uint8_t*& out, size_t& outSize) override
+		{
+			// avail_in/avail_out are 32-bit
+			uInt inChunk = (uInt)std::min<size_t>(inSize, UINT32_MAX);
+			uInt outChunk = (uInt)std::min<size_t>(outSize, UINT32_MAX);
+			m_stream.next_in = const_cast<Bytef*>(in);
+			m_stream.avail_in = inChunk;
+			m_stream.next_out = out;
+			m_stream.avail_out = outChunk;
+
+			int ret = inflate(&m_stream, Z_NO_FLUSH);
+
+			in += inChunk - m_stream.avail_in;
+			inSize -= inChunk - m_stream.avail_in;
+			out += outChunk - m_stream.avail_out;
+			outSize -= outChunk - m_stream.avail_out;
+
+			if (ret == Z_STREAM_END)
+				return true;
+			// Z_BUF_ERROR only means no progress was possible with the buffers given
+			if (ret != Z_OK && ret != Z_BUF_ERROR)
+				throw std::runtime_error("Corrupt zlib stream");
+			return false;
+		}
+
+		std::unique_ptr<DecompressionCodec>
+		clone() const override
+		{
+			return std::make_unique<ZlibCodec>(*this);
+		}
+	};
+#endif
+};
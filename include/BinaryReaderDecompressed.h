@@ -0,0 +1,348 @@
+#pragma once
+
+#include "BinaryReader.h"
+#include "BinaryReaderCodec.h"
+#include "BinaryReaderExceptions.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace BinaryReader
+{
+	// Reads a compressed stream as if it were the uncompressed data
+	// Data is decompressed a block at a time into a small LRU cache, so the whole blob is never held in memory
+	// Every `checkpointInterval` bytes the first pass saves a copy of the decoder state,
+	//   so a seek resumes from the nearest checkpoint before the target instead of from the start
+	class BinaryReaderDecompressed : public BinaryReader
+	{
+		struct Block
+		{
+			std::vector<uint8_t> data;
+			// Block number, or NO_BLOCK for an unused slot
+			size_t index;
+			size_t fill;
+			uint64_t lastUse;
+		};
+
+		struct Checkpoint
+		{
+			size_t block;
+			// Offset into the compressed data of the first byte the decoder has not consumed
+			size_t compressedOffset;
+			std::unique_ptr<DecompressionCodec> codec;
+		};
+
+		static constexpr size_t NO_BLOCK = std::numeric_limits<size_t>::max();
+		static constexpr size_t INPUT_SIZE = 64 * 1024;
+
+		std::unique_ptr<BinaryReader> m_ownedSource;
+		BinaryReader* m_source;
+		size_t m_sourceStart;
+		size_t m_compressedSize;
+
+		size_t m_length;
+		bool m_lengthKnown;
+		size_t m_curPos;
+		size_t m_blockSize;
+		size_t m_checkpointBlocks;
+
+		// The block the cursor is in, for the lock-free fast path
+		const Block* m_current;
+		std::vector<Block> m_cache;
+		uint64_t m_useClock;
+		// Skipped-over blocks are decoded here so they don't evict cached ones
+		std::vector<uint8_t> m_scratch;
+
+		// Decoder position: the next block it will produce
+		std::unique_ptr<DecompressionCodec> m_codec;
+		size_t m_decoderBlock;
+		bool m_decoderFinished;
+		std::vector<uint8_t> m_input;
+		size_t m_inputPos;
+		size_t m_inputFill;
+		size_t m_compressedPos;
+
+		// Sorted by block; the first entry is the start of the stream
+		std::vector<Checkpoint> m_checkpoints;
+
+		void
+		readBytes(void* dst, int count) override
+		{
+			if (m_current != nullptr && m_curPos >= m_current->index * m_blockSize &&
+				m_curPos + count <= m_current->index * m_blockSize + m_current->fill)
+			{
+				std::memcpy(dst, m_current->data.data() + (m_curPos - m_current->index * m_blockSize), count);
+				m_curPos += count;
+				return;
+			}
+			_readSlow((uint8_t*)dst, count);
+		}
+
+		// Exposes the rest of the cached block under the cursor
+		const uint8_t*
+		cursorPtr(size_t& remaining) override
+		{
+			remaining = 0;
+			if (m_lengthKnown && m_curPos >= m_length)
+				return nullptr;
+
+			const Block* block = _blockAt(m_curPos);
+			if (block == nullptr)
+				return nullptr;
+			size_t offset = m_curPos - block->index * m_blockSize;
+			remaining = block->fill - offset;
+			return block->data.data() + offset;
+		}
+
+	public:
+		static constexpr size_t UNKNOWN_LENGTH = std::numeric_limits<size_t>::max();
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+		static constexpr size_t DEFAULT_CACHE_BLOCKS = 4;
+		static constexpr size_t DEFAULT_CHECKPOINT_INTERVAL = 1024 * 1024;
+
+		// Reads compressed data from `source`, starting at its current position up to its end
+		// `source` must outlive this reader, and should not be used while this reader is
+		// Pass the uncompressed length if the container records it. Otherwise the first getLength() call
+		//   decompresses to the end of the stream (building the whole checkpoint index on the way)
+		BinaryReaderDecompressed(BinaryReader& source, std::unique_ptr<DecompressionCodec> codec,
+			size_t uncompressedLength = UNKNOWN_LENGTH,
+			size_t blockSize = DEFAULT_BLOCK_SIZE,
+			size_t cacheBlocks = DEFAULT_CACHE_BLOCKS,
+			size_t checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL)
+			: m_ownedSource(), m_source(&source), m_sourceStart(source.tell()),
+			  m_compressedSize(source.getLength() - source.tell()),
+			  m_length(uncompressedLength == UNKNOWN_LENGTH ? 0 : uncompressedLength),
+			  m_lengthKnown(uncompressedLength != UNKNOWN_LENGTH), m_curPos(0),
+			  m_blockSize(std::max<size_t>(blockSize, 1)),
+			  m_checkpointBlocks(std::max<size_t>(1, checkpointInterval / std::max<size_t>(blockSize, 1))),
+			  m_current(nullptr), m_cache(std::max<size_t>(cacheBlocks, 1)), m_useClock(0), m_scratch(),
+			  m_codec(std::move(codec)), m_decoderBlock(0), m_decoderFinished(false),
+			  m_input(INPUT_SIZE), m_inputPos(0), m_inputFill(0), m_compressedPos(0), m_checkpoints()
+		{
+			if (!m_codec)
+				throw std::invalid_argument("No codec given");
+
+			for (Block& block : m_cache)
+			{
+				block.data.resize(m_blockSize);
+				block.index = NO_BLOCK;
+				block.fill = 0;
+				block.lastUse = 0;
+			}
+			m_checkpoints.push_back({ 0, 0, m_codec->clone() });
+		}
+
+		// Same, but this reader owns the compressed source
+		BinaryReaderDecompressed(std::unique_ptr<BinaryReader> source, std::unique_ptr<DecompressionCodec> codec,
+			size_t uncompressedLength = UNKNOWN_LENGTH,
+			size_t blockSize = DEFAULT_BLOCK_SIZE,
+			size_t cacheBlocks = DEFAULT_CACHE_BLOCKS,
+			size_t checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL)
+			: BinaryReaderDecompressed(*source, std::move(codec), uncompressedLength, blockSize, cacheBlocks, checkpointInterval)
+		{
+			m_ownedSource = std::move(source);
+		}
+
+		BinaryReaderDecompressed(const BinaryReaderDecompressed&) = delete;
+		BinaryReaderDecompressed& operator=(const BinaryReaderDecompressed&) = delete;
+
+		size_t
+		getLength() override
+		{
+			if (!m_lengthKnown)
+				_decodeToEnd();
+			return m_length;
+		}
+
+		BinaryReaderDecompressed&
+		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur) override
+		{
+			_statSeek(offset, way);
+			switch (way)
+			{
+			case std::ios_base::beg:
+				m_curPos = offset;
+				break;
+			case std::ios_base::cur:
+				m_curPos += offset;
+				break;
+			case std::ios_base::end:
+				m_curPos = getLength() + offset;
+				break;
+			}
+			return *this;
+		}
+
+		size_t
+		tell() override
+		{
+			return m_curPos;
+		}
+
+		size_t
+		getCheckpointCount() const
+		{
+			return m_checkpoints.size();
+		}
+
+	private:
+		void
+		_readSlow(uint8_t* dst, size_t count)
+		{
+			if (m_lengthKnown && m_curPos + count > m_length)
+				throw std::runtime_error("Read past end of stream");
+
+			while (count > 0)
+			{
+				const Block* block = _blockAt(m_curPos);
+				size_t offset = block == nullptr ? 0 : m_curPos - block->index * m_blockSize;
+				if (block == nullptr || offset >= block->fill)
+					throw std::runtime_error("Read past end of stream");
+
+				size_t available = std::min(count, block->fill - offset);
+				std::memcpy(dst, block->data.data() + offset, available);
+				dst += available;
+				count -= available;
+				m_curPos += available;
+			}
+		}
+
+		// Cached block holding `pos`, decoding it if needed. nullptr past the end of the stream
+		const Block*
+		_blockAt(size_t pos)
+		{
+			size_t index = pos / m_blockSize;
+			Block* victim = &m_cache[0];
+			for (Block& block : m_cache)
+			{
+				if (block.index == index)
+				{
+					block.lastUse = ++m_useClock;
+					m_current = &block;
+					return &block;
+				}
+				if (block.lastUse < victim->lastUse)
+					victim = &block;
+			}
+
+			m_current = nullptr;
+			victim->index = NO_BLOCK;
+			if (!_decodeUpTo(index, victim->data.data(), victim->fill))
+				return nullptr;
+
+			victim->index = index;
+			victim->lastUse = ++m_useClock;
+			m_current = victim;
+			return victim;
+		}
+
+		// Moves the decoder to block `index` and decodes it into `dst`
+		// Returns false if the stream ends before that block
+		bool
+		_decodeUpTo(size_t index, uint8_t* dst, size_t& fill)
+		{
+			// Restart from the nearest checkpoint if it beats decoding forward from here
+			auto next = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), index,
+				[](size_t value, const Checkpoint& checkpoint) { return value < checkpoint.block; });
+			const Checkpoint& nearest = *(next - 1);
+			if (index < m_decoderBlock || nearest.block > m_decoderBlock)
+				_restore(nearest);
+
+			if (m_scratch.size() < m_blockSize)
+				m_scratch.resize(m_blockSize);
+			while (m_decoderBlock < index)
+			{
+				size_t skipped = 0;
+				if (!_decodeBlock(m_scratch.data(), skipped))
+					return false;
+			}
+			return _decodeBlock(dst, fill);
+		}
+
+		void
+		_restore(const Checkpoint& checkpoint)
+		{
+			m_codec = checkpoint.codec->clone();
+			m_decoderBlock = checkpoint.block;
+			m_decoderFinished = false;
+			m_compressedPos = checkpoint.compressedOffset;
+			m_inputPos = 0;
+			m_inputFill = 0;
+		}
+
+		// Decodes the decoder's next block. Returns false if the stream has already ended
+		bool
+		_decodeBlock(uint8_t* dst, size_t& fill)
+		{
+			if (m_decoderFinished)
+				return false;
+
+			// First pass over this part of the stream: remember where the block starts
+			if (m_decoderBlock % m_checkpointBlocks == 0 && m_decoderBlock > m_checkpoints.back().block)
+				m_checkpoints.push_back({ m_decoderBlock, m_compressedPos - (m_inputFill - m_inputPos), m_codec->clone() });
+
+			uint8_t* out = dst;
+			size_t outSize = m_blockSize;
+			while (outSize > 0 && !m_decoderFinished)
+			{
+				if (m_inputPos == m_inputFill)
+					_fillInput();
+
+				const uint8_t* in = m_input.data() + m_inputPos;
+				size_t inSize = m_inputFill - m_inputPos;
+				size_t before = outSize;
+				m_decoderFinished = m_codec->decompress(in, inSize, out, outSize);
+
+				bool consumed = in != m_input.data() + m_inputPos;
+				m_inputPos = in - m_input.data();
+				if (!m_decoderFinished && !consumed && before == outSize && m_compressedPos == m_compressedSize)
+					throw std::runtime_error("Compressed stream is truncated");
+			}
+
+			fill = m_blockSize - outSize;
+			m_decoderBlock++;
+			if (m_decoderFinished)
+			{
+				size_t length = (m_decoderBlock - 1) * m_blockSize + fill;
+				if (m_lengthKnown && length != m_length)
+					throw std::runtime_error("Uncompressed length does not match the stream");
+				m_length = length;
+				m_lengthKnown = true;
+			}
+			return fill > 0 || !m_decoderFinished;
+		}
+
+		void
+		_fillInput()
+		{
+			size_t count = std::min(m_input.size(), m_compressedSize - m_compressedPos);
+			if (count > 0)
+			{
+				m_source->seek(m_sourceStart + m_compressedPos, std::ios::beg);
+				m_source->readScalarArray<uint8_t>(m_input.data(), count);
+			}
+			m_compressedPos += count;
+			m_inputPos = 0;
+			m_inputFill = count;
+		}
+
+		void
+		_decodeToEnd()
+		{
+			if (m_scratch.size() < m_blockSize)
+				m_scratch.resize(m_blockSize);
+
+			size_t fill = 0;
+			while (!m_lengthKnown)
+			{
+				if (!_decodeUpTo(m_decoderBlock, m_scratch.data(), fill))
+					break;
+			}
+		}
+	};
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "BinaryReaderBasic.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <memory_resource>
+#include <utility>
+
+namespace BinaryReader
+{
+	// Fixes the byte order of a format once, so its parsing code calls readScalar everywhere
+	//   BigEndianReader reader(file);
+	//   uint32_t size = reader.readScalar<uint32_t>();
+	// Each read picks the LE or BE variant of the wrapped reader at compile time. Data in host order is
+	//   read as is, anything else is read the same way and then byte-swapped
+	// Reads without a byte order (strings, LEB, views, ...) go through get()
+	template <std::endian Order, class Reader>
+	class EndianReader
+	{
+		static constexpr bool BIG = Order == std::endian::big;
+
+		Reader& m_reader;
+
+	public:
+		static constexpr std::endian ORDER = Order;
+
+		explicit EndianReader(Reader& reader)
+			: m_reader(reader)
+		{
+		}
+
+		Reader&
+		get()
+		{
+			return m_reader;
+		}
+
+		EndianReader&
+		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur)
+		{
+			m_reader.seek(offset, way);
+			return *this;
+		}
+
+		size_t
+		tell()
+		{
+			return m_reader.tell();
+		}
+
+		size_t
+		getLength()
+		{
+			return m_reader.getLength();
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Scalars
+
+		template <typename T>
+		T
+		readScalar()
+		{
+			if constexpr (BIG)
+				return m_reader.template readScalarBE<T>();
+			else
+				return m_reader.template readScalar<T>();
+		}
+
+		// Same arguments as the wrapped reader's readScalarSafe, flags included for floats
+		template <typename T, typename... Args>
+		T
+		readScalarSafe(Args&&... args)
+		{
+			if constexpr (BIG)
+				return m_reader.template readScalarBESafe<T>(std::forward<Args>(args)...);
+			else
+				return m_reader.template readScalarSafe<T>(std::forward<Args>(args)...);
+		}
+
+		template <typename T>
+		T
+		readAt(size_t offset) const
+		{
+			if constexpr (BIG)
+				return m_reader.template readAtBE<T>(offset);
+			else
+				return m_reader.template readAt<T>(offset);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Arrays
+
+		template <typename T>
+		void
+		readScalarArray(T* dst, size_t count)
+		{
+			if constexpr (BIG)
+				m_reader.readScalarArrayBE(dst, count);
+			else
+				m_reader.readScalarArray(dst, count);
+		}
+
+		template <typename T, typename... Args>
+		void
+		readScalarArraySafe(T* dst, size_t count, Args&&... args)
+		{
+			if constexpr (BIG)
+				m_reader.template readScalarArrayBESafe<T>(dst, count, std::forward<Args>(args)...);
+			else
+				m_reader.template readScalarArraySafe<T>(dst, count, std::forward<Args>(args)...);
+		}
+
+		template <typename T>
+		void
+		readArrayAt(size_t offset, T* dst, size_t count) const
+		{
+			if constexpr (BIG)
+				m_reader.readArrayAtBE(offset, dst, count);
+			else
+				m_reader.readArrayAt(offset, dst, count);
+		}
+
+		template <typename T>
+		std::pmr::vector<T>
+		readVector(size_t count, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			if constexpr (BIG)
+				return m_reader.template readVectorBE<T>(count, resource);
+			else
+				return m_reader.template readVector<T>(count, resource);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Half-Floats
+
+		float
+		readHalf()
+		{
+			if constexpr (BIG)
+				return m_reader.readHalfBE();
+			else
+				return m_reader.readHalf();
+		}
+
+		template <typename... Args>
+		float
+		readHalfSafe(Args&&... args)
+		{
+			if constexpr (BIG)
+				return m_reader.readHalfBESafe(std::forward<Args>(args)...);
+			else
+				return m_reader.readHalfSafe(std::forward<Args>(args)...);
+		}
+
+		void
+		readHalfArray(float* dst, size_t count)
+		{
+			if constexpr (BIG)
+				m_reader.readHalfArrayBE(dst, count);
+			else
+				m_reader.readHalfArray(dst, count);
+		}
+
+		template <typename... Args>
+		void
+		readHalfArraySafe(float* dst, size_t count, Args&&... args)
+		{
+			if constexpr (BIG)
+				m_reader.readHalfArrayBESafe(dst, count, std::forward<Args>(args)...);
+			else
+				m_reader.readHalfArraySafe(dst, count, std::forward<Args>(args)...);
+		}
+
+#ifdef BINARYREADER_HAS_EXPECTED
+		//////////////////////////////////////////////////////////////////////////////
+		// Non-throwing checks
+
+		template <typename T, typename... Args>
+		auto
+		tryReadScalar(Args&&... args)
+		{
+			if constexpr (BIG)
+				return m_reader.template tryReadScalarBE<T>(std::forward<Args>(args)...);
+			else
+				return m_reader.template tryReadScalar<T>(std::forward<Args>(args)...);
+		}
+
+		template <typename T, typename... Args>
+		auto
+		tryReadScalarArray(T* dst, size_t count, Args&&... args)
+		{
+			if constexpr (BIG)
+				return m_reader.template tryReadScalarArrayBE<T>(dst, count, std::forward<Args>(args)...);
+			else
+				return m_reader.template tryReadScalarArray<T>(dst, count, std::forward<Args>(args)...);
+		}
+
+		template <typename... Args>
+		auto
+		tryReadHalf(Args&&... args)
+		{
+			if constexpr (BIG)
+				return m_reader.tryReadHalfBE(std::forward<Args>(args)...);
+			else
+				return m_reader.tryReadHalf(std::forward<Args>(args)...);
+		}
+
+		template <typename... Args>
+		auto
+		tryReadHalfArray(float* dst, size_t count, Args&&... args)
+		{
+			if constexpr (BIG)
+				return m_reader.tryReadHalfArrayBE(dst, count, std::forward<Args>(args)...);
+			else
+				return m_reader.tryReadHalfArray(dst, count, std::forward<Args>(args)...);
+		}
+#endif
+	};
+
+	template <class Reader>
+	using LittleEndianReader = EndianReader<std::endian::little, Reader>;
+
+	template <class Reader>
+	using BigEndianReader = EndianReader<std::endian::big, Reader>;
+};
@@ -2,49 +2,157 @@
 
 #include "BinaryReaderExceptions.h"
 #include "BinaryReader.h"
+#include "BinaryReaderBlockCache.h"
 
+#include <algorithm>
 #include <fstream>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+
+// MinGW has <unistd.h>, but no pread or O_CLOEXEC
+#if !defined(_WIN32) && __has_include(<unistd.h>)
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#define BINARYREADER_HAS_PREAD 1
+#endif
 
 namespace BinaryReader
 {
+	// Given a BlockCache (POSIX only), reads are served from the cache's blocks instead of an ifstream,
+	//   so several readers of one file share the blocks any of them has loaded
 	class BinaryReaderFile : public BinaryReader
 	{
+		// Positional reads use their own handle so they never disturb `_reader`
+		struct PositionalHandle
+		{
+#ifdef BINARYREADER_HAS_PREAD
+			int fd;
+
+			explicit PositionalHandle(const std::string& path)
+				: fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+			{
+				if (fd < 0)
+					throw std::runtime_error("File does not exist");
+			}
+
+			~PositionalHandle()
+			{
+				::close(fd);
+			}
+#else
+			std::mutex lock;
+			std::ifstream stream;
+
+			explicit PositionalHandle(const std::string& path)
+				: lock(), stream(path, std::ifstream::in | std::ifstream::binary)
+			{
+				if (stream.fail())
+					throw std::runtime_error("File does not exist");
+			}
+#endif
+		};
+
+		// Most readers never read positionally, so the handle is opened on the first readBytesAt
+		// The path may have been renamed or replaced by then. With pread, the new handle must be the file
+		//   that was at the path when `_reader` opened it (same device and inode), or the read throws
+		struct Positional
+		{
+			std::string path;
+			uint64_t device = 0;
+			uint64_t inode = 0;
+			std::once_flag opened;
+			std::unique_ptr<PositionalHandle> handle;
+		};
+
 		std::ifstream _reader;
 		size_t m_length;
+		std::unique_ptr<Positional> m_positional;
+		// Only set when reading through a BlockCache, which then replaces `_reader`
+		BlockCache* m_cache = nullptr;
+		BlockCache::FileLease m_file;
+		size_t m_curPos = 0;
+		// The cached block under the cursor, and its file offset
+		std::shared_ptr<const BlockCache::Block> m_block;
+		size_t m_blockStart = 0;
 
 	private:
 		void
 		readBytes(void* dst, int count) override
 		{
+			if (this->m_cache != nullptr)
+			{
+				this->_readCached((uint8_t*)dst, count);
+				return;
+			}
 			this->_reader.read((char*)dst, count);
 		}
-		
-		void
-		readBytesBE(void* dst, int count) override
+
+		// Only cached readers have a buffer of their own to expose
+		const uint8_t*
+		cursorPtr(size_t& remaining) override
 		{
-			for (size_t i = count; i > 0; i--)
-				this->_reader.read((char*)dst + i, 1);
-		}
+			if (this->m_cache == nullptr || this->m_curPos >= this->m_length)
+			{
+				remaining = 0;
+				return nullptr;
+			}
+			if (!this->_inBlock())
+				this->_loadCursorBlock();
 
+			remaining = this->m_blockStart + this->m_block->size - this->m_curPos;
+			return this->m_block->data.get() + (this->m_curPos - this->m_blockStart);
+		}
+		
 	public:
 		BinaryReaderFile()
 		{
 			this->m_length = 0;
-			this->seek(0, std::ios_base::beg);
+			this->_reader.seekg(0, std::ios_base::beg);
 		}
 
-		BinaryReaderFile(const std::string& filePath)
+		BinaryReaderFile(const std::string& filePath, BlockCache* cache = nullptr)
 		{
+			if (cache != nullptr)
+			{
+#ifdef BINARYREADER_HAS_PREAD
+				// The cache reads through the positional handle alone, so it is opened right away
+				this->m_positional = std::make_unique<Positional>();
+				this->m_positional->handle = std::make_unique<PositionalHandle>(filePath);
+				struct stat fileStat;
+				if (::fstat(this->m_positional->handle->fd, &fileStat) != 0)
+					throw std::runtime_error("Cannot stat file");
+				this->m_length = (size_t)fileStat.st_size;
+				this->m_cache = cache;
+				this->m_file = cache->acquireFile(fileStat);
+				return;
+#else
+				throw std::logic_error("Reading through a block cache needs pread");
+#endif
+			}
+
 			this->_reader = std::ifstream(filePath, std::ifstream::in | std::ifstream::binary);
 
 			if (this->_reader.fail())
 				throw std::runtime_error("File does not exist");
 			
 			this->setLength();
-			this->seek(0, std::ios_base::beg);
+			this->_reader.seekg(0, std::ios_base::beg);
+
+			this->m_positional = std::make_unique<Positional>();
+			this->m_positional->path = filePath;
+#ifdef BINARYREADER_HAS_PREAD
+			struct stat fileStat;
+			if (::stat(filePath.c_str(), &fileStat) != 0)
+				throw std::runtime_error("Cannot stat file");
+			this->m_positional->device = (uint64_t)fileStat.st_dev;
+			this->m_positional->inode = (uint64_t)fileStat.st_ino;
+#endif
 		}
 
 		size_t
@@ -56,22 +164,156 @@ namespace BinaryReader
 		BinaryReaderFile&
 		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur) override
 		{
-			_reader.seekg(offset, way);
+			_statSeek(offset, way);
+			if (this->m_cache == nullptr)
+			{
+				_reader.seekg(offset, way);
+				return *this;
+			}
+
+			switch (way)
+			{
+			case std::ios_base::beg:
+				this->m_curPos = offset;
+				break;
+			case std::ios_base::cur:
+				this->m_curPos += offset;
+				break;
+			case std::ios_base::end:
+				this->m_curPos = this->m_length + offset;
+				break;
+			}
 			return *this;
 		}
 
 		size_t
 		tell() override
 		{
+			if (this->m_cache != nullptr)
+				return this->m_curPos;
 			return (size_t)this->_reader.tellg();
 		}
 
+		void
+		readBytesAt(void* dst, size_t count, size_t offset) const override
+		{
+			if (!this->m_positional)
+				throw std::logic_error("No file is open");
+			if (offset > this->m_length || count > this->m_length - offset)
+				throw std::out_of_range("Positional read out of bounds");
+
+			if (this->m_cache != nullptr)
+			{
+				this->m_cache->read(this->m_file.id(), dst, count, offset, [this](uint8_t* blockDst, size_t size, uint64_t index) {
+					return this->_loadBlock(index, blockDst, size);
+				});
+				return;
+			}
+			this->_pread(dst, count, offset);
+		}
+
 	private:
 		void
 		setLength()
 		{
-			this->seek(0, std::ios_base::end);
+			this->_reader.seekg(0, std::ios_base::end);
 			this->m_length = this->tell();
 		}
+
+		PositionalHandle&
+		_positionalHandle() const
+		{
+			Positional& positional = *this->m_positional;
+			std::call_once(positional.opened, [&] {
+				if (positional.handle != nullptr)
+					return;
+				auto handle = std::make_unique<PositionalHandle>(positional.path);
+#ifdef BINARYREADER_HAS_PREAD
+				struct stat fileStat;
+				if (::fstat(handle->fd, &fileStat) != 0)
+					throw std::runtime_error("Cannot stat file");
+				if ((uint64_t)fileStat.st_dev != positional.device || (uint64_t)fileStat.st_ino != positional.inode)
+					throw std::runtime_error("File was replaced since it was opened");
+#endif
+				positional.handle = std::move(handle);
+			});
+			return *positional.handle;
+		}
+
+		void
+		_pread(void* dst, size_t count, size_t offset) const
+		{
+			PositionalHandle& handle = this->_positionalHandle();
+#ifdef BINARYREADER_HAS_PREAD
+			uint8_t* out = (uint8_t*)dst;
+			while (count > 0)
+			{
+				ssize_t got = ::pread(handle.fd, out, count, (off_t)offset);
+				if (got < 0 && errno == EINTR)
+					continue;
+				if (got <= 0)
+					throw std::runtime_error("Failed to read file");
+				out += got;
+				count -= (size_t)got;
+				offset += (size_t)got;
+			}
+#else
+			std::lock_guard<std::mutex> guard(handle.lock);
+			handle.stream.seekg(offset, std::ios::beg);
+			handle.stream.read((char*)dst, count);
+			if (handle.stream.fail())
+				throw std::runtime_error("Failed to read file");
+#endif
+		}
+
+		bool
+		_inBlock() const
+		{
+			return this->m_block != nullptr && this->m_curPos >= this->m_blockStart
+				&& this->m_curPos < this->m_blockStart + this->m_block->size;
+		}
+
+		void
+		_readCached(uint8_t* dst, size_t count)
+		{
+			if (this->m_curPos > this->m_length || count > this->m_length - this->m_curPos)
+				throw std::runtime_error("Read past end of file");
+
+			while (count > 0)
+			{
+				if (!this->_inBlock())
+					this->_loadCursorBlock();
+
+				size_t available = std::min(count, this->m_blockStart + this->m_block->size - this->m_curPos);
+				std::memcpy(dst, this->m_block->data.get() + (this->m_curPos - this->m_blockStart), available);
+				dst += available;
+				count -= available;
+				this->m_curPos += available;
+			}
+		}
+
+		void
+		_loadCursorBlock()
+		{
+			size_t blockSize = this->m_cache->blockSize();
+			uint64_t index = this->m_curPos / blockSize;
+			this->m_block = this->m_cache->get(this->m_file.id(), index, [&](uint8_t* dst, size_t size) {
+				return this->_loadBlock(index, dst, size);
+			});
+			this->m_blockStart = index * blockSize;
+			// The file shrank since it was opened
+			if (!this->_inBlock())
+				throw std::runtime_error("Read past end of file");
+		}
+
+		// Block `index` of the file, as much of it as the file has
+		size_t
+		_loadBlock(uint64_t index, uint8_t* dst, size_t blockSize) const
+		{
+			size_t offset = index * blockSize;
+			size_t size = offset < this->m_length ? std::min(blockSize, this->m_length - offset) : 0;
+			this->_pread(dst, size, offset);
+			return size;
+		}
 	};
 };
\ No newline at end of file
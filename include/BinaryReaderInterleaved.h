@@ -0,0 +1,162 @@
+#pragma once
+
+#include "BinaryReaderSimd.h"
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace BinaryReader
+{
+	// Element types an interleaved attribute can be stored as
+	enum class AttributeType
+	{
+		Int8,
+		UInt8,
+		Int16,
+		UInt16,
+		Int32,
+		UInt32,
+		Int64,
+		UInt64,
+		Float16,
+		Float32,
+		Float64
+	};
+
+	inline size_t
+	attributeTypeSize(AttributeType type)
+	{
+		switch (type)
+		{
+		case AttributeType::Int8:
+		case AttributeType::UInt8:
+			return 1;
+		case AttributeType::Int16:
+		case AttributeType::UInt16:
+		case AttributeType::Float16:
+			return 2;
+		case AttributeType::Int32:
+		case AttributeType::UInt32:
+		case AttributeType::Float32:
+			return 4;
+		case AttributeType::Int64:
+		case AttributeType::UInt64:
+		case AttributeType::Float64:
+			return 8;
+		}
+		return 0;
+	}
+
+	// One attribute of an interleaved record, and the contiguous array it is decoded into
+	// `dst` receives `components` elements per record. Halfs are widened to float, everything else is copied as-is
+	struct Attribute
+	{
+		size_t offset;
+		AttributeType type;
+		size_t components;
+		std::endian order;
+		void* dst;
+
+		template <typename T>
+		requires std::integral<T> || std::floating_point<T>
+		static Attribute
+		of(size_t offset, size_t components, T* dst, std::endian order = std::endian::little)
+		{
+			return { offset, _typeOf<T>(), components, order, dst };
+		}
+
+		static Attribute
+		half(size_t offset, size_t components, float* dst, std::endian order = std::endian::little)
+		{
+			return { offset, AttributeType::Float16, components, order, dst };
+		}
+
+		// Bytes taken up in each record
+		size_t
+		width() const
+		{
+			return attributeTypeSize(type) * components;
+		}
+
+	private:
+		template <typename T>
+		static constexpr AttributeType
+		_typeOf()
+		{
+			if constexpr (std::floating_point<T>)
+				return sizeof(T) == 4 ? AttributeType::Float32 : AttributeType::Float64;
+			else if constexpr (sizeof(T) == 1)
+				return std::signed_integral<T> ? AttributeType::Int8 : AttributeType::UInt8;
+			else if constexpr (sizeof(T) == 2)
+				return std::signed_integral<T> ? AttributeType::Int16 : AttributeType::UInt16;
+			else if constexpr (sizeof(T) == 4)
+				return std::signed_integral<T> ? AttributeType::Int32 : AttributeType::UInt32;
+			else
+				return std::signed_integral<T> ? AttributeType::Int64 : AttributeType::UInt64;
+		}
+	};
+
+	namespace Interleaved
+	{
+		inline void
+		validate(size_t stride, const Attribute* attributes, size_t attributeCount)
+		{
+			for (size_t a = 0; a < attributeCount; a++)
+			{
+				const Attribute& attribute = attributes[a];
+				if (attribute.dst == nullptr)
+					throw std::invalid_argument("Attribute has no destination");
+				if (attribute.offset + attribute.width() > stride)
+					throw std::invalid_argument("Attribute does not fit in the record stride");
+			}
+		}
+
+		// Decodes `count` records starting at `records` into elements [first, first + count) of every attribute
+		// Each attribute is gathered into its destination, then byte-swapped or widened in place
+		inline void
+		decode(const uint8_t* records, size_t stride, size_t count, size_t first, const Attribute* attributes, size_t attributeCount)
+		{
+			for (size_t a = 0; a < attributeCount; a++)
+			{
+				const Attribute& attribute = attributes[a];
+				const size_t elementSize = attributeTypeSize(attribute.type);
+				const size_t elements = count * attribute.components;
+				const bool swap = attribute.order != std::endian::native && elementSize > 1;
+				const uint8_t* src = records + attribute.offset;
+
+				if (attribute.type == AttributeType::Float16)
+				{
+					// Raw halfs land in the upper half of this block's floats, then widen front to back
+					float* out = (float*)attribute.dst + first * attribute.components;
+					uint16_t* raw = (uint16_t*)out + elements;
+					Simd::gatherStrided((uint8_t*)raw, src, stride, attribute.width(), count);
+					if (swap)
+						Simd::byteSwapArray(raw, elements);
+					Simd::halfToFloatArray(raw, out, elements);
+					continue;
+				}
+
+				uint8_t* out = (uint8_t*)attribute.dst + first * attribute.width();
+				Simd::gatherStrided(out, src, stride, attribute.width(), count);
+				if (!swap)
+					continue;
+
+				switch (elementSize)
+				{
+				case 2:
+					Simd::byteSwapArray((uint16_t*)out, elements);
+					break;
+				case 4:
+					Simd::byteSwapArray((uint32_t*)out, elements);
+					break;
+				case 8:
+					Simd::byteSwapArray((uint64_t*)out, elements);
+					break;
+				}
+			}
+		}
+	};
+};
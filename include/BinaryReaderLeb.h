@@ -0,0 +1,213 @@
+#pragma once
+
+#include "BinaryReaderSimd.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace BinaryReader
+{
+	// LEB128 decoding straight out of memory
+	// The array decoders load 8 bytes at a time and find every terminating byte in the word with a mask
+	// Each value's 7-bit groups are then packed together without a per-byte loop
+	namespace Leb
+	{
+		constexpr uint64_t CONTINUATION_BITS = 0x8080808080808080ull;
+
+		// Number of 7-bit groups read before BasicReader::_readULEB's final byte
+		inline int
+		groupLimit(int maxBits)
+		{
+			return maxBits > 1 ? (maxBits - 1 + 6) / 7 : 0;
+		}
+
+		inline uint64_t
+		_load64(const uint8_t* src)
+		{
+			uint64_t word;
+			std::memcpy(&word, src, sizeof(uint64_t));
+			if constexpr (std::endian::native == std::endian::big)
+				word = Simd::bswap64(word);
+			return word;
+		}
+
+		// Packs the low 7 bits of each byte into a contiguous integer
+		inline uint64_t
+		_compact(uint64_t word)
+		{
+#ifdef __BMI2__
+			return _pext_u64(word, 0x7f7f7f7f7f7f7f7full);
+#else
+			word &= 0x7f7f7f7f7f7f7f7full;
+			word = (word & 0x007f007f007f007full) | ((word & 0x7f007f007f007f00ull) >> 1);
+			word = (word & 0x00003fff00003fffull) | ((word & 0x3fff00003fff0000ull) >> 2);
+			word = (word & 0x000000000fffffffull) | ((word & 0x0fffffff00000000ull) >> 4);
+			return word;
+#endif
+		}
+
+		// Byte-for-byte the same as BasicReader::_readULEB
+		// Returns bytes consumed, or 0 if `avail` ends mid-value
+		inline size_t
+		decodeULEB(const uint8_t* src, size_t avail, uint64_t& out, int maxBits = 64)
+		{
+			uint64_t result = 0;
+			size_t pos = 0;
+
+			for (int curShift = 0; curShift < maxBits - 1; curShift += 7)
+			{
+				if (pos >= avail)
+					return 0;
+				uint8_t curByte = src[pos++];
+				result |= (curByte & 0x7Full) << curShift;
+
+				if (curByte <= 0x7ful)
+				{
+					out = result;
+					return pos;
+				}
+			}
+
+			if (pos >= avail)
+				return 0;
+			result |= (uint64_t)src[pos++] << (maxBits - 1);
+			out = result;
+			return pos;
+		}
+
+		// Byte-for-byte the same as BasicReader::_readSLEB
+		inline size_t
+		decodeSLEB(const uint8_t* src, size_t avail, int64_t& out, int maxBits = 64)
+		{
+			uint64_t result = 0;
+			size_t pos = 0;
+			int shift = 0;
+			uint8_t curByte;
+
+			do
+			{
+				if (pos >= avail)
+					return 0;
+				curByte = src[pos++];
+				if (shift < 64)
+					result |= (curByte & 0x7Full) << shift;
+				shift += 7;
+			} while ((curByte & 0x80) && shift < maxBits);
+
+			if (shift < 64 && (curByte & 0x40))
+				result |= ~0ull << shift;
+
+			out = (int64_t)result;
+			return pos;
+		}
+
+		// Decodes up to `count` values. Stops early when a value runs past `avail`
+		// Returns bytes consumed; `decoded` receives the number of values written
+		inline size_t
+		decodeULEBArray(const uint8_t* src, size_t avail, uint64_t* dst, size_t count, size_t& decoded, int maxBits = 64)
+		{
+			const size_t limit = (size_t)groupLimit(maxBits);
+			size_t pos = 0;
+			size_t i = 0;
+
+			while (i < count)
+			{
+				size_t consumed = 0;
+				if (avail - pos >= sizeof(uint64_t))
+				{
+					// Walk every value that terminates inside this word
+					// Each step only clears the lowest terminator bit, so there is no load-to-load dependency
+					uint64_t word = _load64(src + pos);
+					uint64_t terminators = ~word & CONTINUATION_BITS;
+
+					// 8 single-byte values, the common case for small IDs and lengths
+					if (terminators == CONTINUATION_BITS && limit > 0 && count - i >= 8)
+					{
+						for (size_t b = 0; b < 8; b++)
+							dst[i + b] = src[pos + b];
+						i += 8;
+						pos += 8;
+						continue;
+					}
+
+					while (terminators != 0 && i < count)
+					{
+						size_t end = (size_t)std::countr_zero(terminators) / 8 + 1;
+						if (end - consumed > limit)
+							break;
+						// Keep every bit up to and including the terminating byte, then drop earlier values
+						dst[i++] = _compact((word & (terminators ^ (terminators - 1))) >> (consumed * 8));
+						consumed = end;
+						terminators &= terminators - 1;
+					}
+				}
+
+				if (consumed == 0)
+				{
+					// Long value, near the end of the buffer, or past the group limit
+					consumed = decodeULEB(src + pos, avail - pos, dst[i], maxBits);
+					if (consumed == 0)
+						break;
+					i++;
+				}
+				pos += consumed;
+			}
+
+			decoded = i;
+			return pos;
+		}
+
+		inline size_t
+		decodeSLEBArray(const uint8_t* src, size_t avail, int64_t* dst, size_t count, size_t& decoded, int maxBits = 64)
+		{
+			const size_t limit = (size_t)(maxBits + 6) / 7;
+			size_t pos = 0;
+			size_t i = 0;
+
+			while (i < count)
+			{
+				size_t consumed = 0;
+				if (avail - pos >= sizeof(uint64_t))
+				{
+					uint64_t word = _load64(src + pos);
+					uint64_t terminators = ~word & CONTINUATION_BITS;
+					while (terminators != 0 && i < count)
+					{
+						size_t end = (size_t)std::countr_zero(terminators) / 8 + 1;
+						size_t length = end - consumed;
+						if (length > limit)
+							break;
+						uint64_t value = _compact((word & (terminators ^ (terminators - 1))) >> (consumed * 8));
+						// Sign-extend from the top bit of the last group
+						size_t bits = length * 7;
+						if ((value >> (bits - 1)) & 1)
+							value |= ~0ull << bits;
+						dst[i++] = (int64_t)value;
+						consumed = end;
+						terminators &= terminators - 1;
+					}
+				}
+
+				if (consumed == 0)
+				{
+					consumed = decodeSLEB(src + pos, avail - pos, dst[i], maxBits);
+					if (consumed == 0)
+						break;
+					i++;
+				}
+				pos += consumed;
+			}
+
+			decoded = i;
+			return pos;
+		}
+
+		inline int64_t
+		zigZagDecode(uint64_t value)
+		{
+			return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+		}
+	};
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "BinaryReader.h"
+#include "BinaryReaderSlice.h"
+#include "BinaryReaderExceptions.h"
+
+#include <cstdint>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BinaryReader
+{
+	// Access pattern hints forwarded to madvise
+	enum class MapAdvice
+	{
+		Normal,
+		Sequential,
+		Random,
+		WillNeed
+	};
+
+	// Maps the whole file read-only into memory (POSIX)
+	// Reads are served straight out of the page cache, and slices point into the mapping
+	class BinaryReaderMapped : public BinaryReader
+	{
+		uint8_t* m_dataPtr;
+		size_t m_size;
+		size_t m_curPos;
+
+		void
+		readBytes(void* dst, int count) override
+		{
+			_check(count);
+			std::memcpy(dst, m_dataPtr + m_curPos, count);
+			m_curPos += count;
+		}
+
+		const uint8_t*
+		cursorPtr(size_t& remaining) override
+		{
+			remaining = m_curPos < m_size ? m_size - m_curPos : 0;
+			return m_dataPtr + m_curPos;
+		}
+
+		void
+		_check(size_t count) const
+		{
+			if constexpr (DEFAULT_BOUNDS == Bounds::Checked)
+			{
+				if (m_curPos > m_size || count > m_size - m_curPos)
+					throw std::out_of_range("Read past end of data");
+			}
+		}
+
+	public:
+		BinaryReaderMapped()
+			: m_dataPtr(nullptr), m_size(0), m_curPos(0)
+		{
+		}
+
+		BinaryReaderMapped(const std::string& filePath)
+			: m_dataPtr(nullptr), m_size(0), m_curPos(0)
+		{
+			int fd = ::open(filePath.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw std::runtime_error("File does not exist");
+
+			struct stat fileStat;
+			if (::fstat(fd, &fileStat) != 0)
+			{
+				::close(fd);
+				throw std::runtime_error("Cannot stat file");
+			}
+			m_size = (size_t)fileStat.st_size;
+
+			// mmap rejects zero-length mappings
+			if (m_size > 0)
+			{
+				void* mapped = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mapped == MAP_FAILED)
+				{
+					::close(fd);
+					throw std::runtime_error("Cannot map file");
+				}
+				m_dataPtr = (uint8_t*)mapped;
+			}
+
+			// The mapping keeps its own reference to the file
+			::close(fd);
+		}
+
+		BinaryReaderMapped(const BinaryReaderMapped&) = delete;
+		BinaryReaderMapped& operator=(const BinaryReaderMapped&) = delete;
+
+		BinaryReaderMapped(BinaryReaderMapped&& other) noexcept
+			: m_dataPtr(other.m_dataPtr), m_size(other.m_size), m_curPos(other.m_curPos)
+		{
+			other.m_dataPtr = nullptr;
+			other.m_size = 0;
+			other.m_curPos = 0;
+		}
+
+		BinaryReaderMapped&
+		operator=(BinaryReaderMapped&& other) noexcept
+		{
+			if (this != &other)
+			{
+				unmap();
+				m_dataPtr = other.m_dataPtr;
+				m_size = other.m_size;
+				m_curPos = other.m_curPos;
+				other.m_dataPtr = nullptr;
+				other.m_size = 0;
+				other.m_curPos = 0;
+			}
+			return *this;
+		}
+
+		~BinaryReaderMapped()
+		{
+			unmap();
+		}
+
+		size_t
+		getLength() override
+		{
+			return m_size;
+		}
+
+		const uint8_t*
+		getPtr()
+		{
+			return m_dataPtr;
+		}
+
+		BinaryReaderMapped&
+		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur) override
+		{
+			_statSeek(offset, way);
+			switch (way)
+			{
+			case std::ios_base::beg:
+				m_curPos = offset;
+				break;
+			case std::ios_base::cur:
+				m_curPos += offset;
+				break;
+			case std::ios_base::end:
+				m_curPos = m_size + offset;
+				break;
+			}
+			return *this;
+		}
+
+		size_t
+		tell() override
+		{
+			return m_curPos;
+		}
+
+		void
+		readBytesAt(void* dst, size_t count, size_t offset) const override
+		{
+			if (offset > m_size || count > m_size - offset)
+				throw std::out_of_range("Positional read out of bounds");
+			std::memcpy(dst, m_dataPtr + offset, count);
+		}
+
+		// Hint the kernel about upcoming access. A length of 0 covers the rest of the file
+		BinaryReaderMapped&
+		advise(MapAdvice advice, size_t offset = 0, size_t length = 0)
+		{
+			if (m_dataPtr == nullptr || offset >= m_size)
+				return *this;
+			if (length == 0 || offset + length > m_size)
+				length = m_size - offset;
+
+			// madvise requires a page-aligned start address
+			size_t pageSize = (size_t)::sysconf(_SC_PAGESIZE);
+			size_t alignedOffset = offset - (offset % pageSize);
+			length += offset - alignedOffset;
+
+			int nativeAdvice = MADV_NORMAL;
+			switch (advice)
+			{
+			case MapAdvice::Normal:
+				nativeAdvice = MADV_NORMAL;
+				break;
+			case MapAdvice::Sequential:
+				nativeAdvice = MADV_SEQUENTIAL;
+				break;
+			case MapAdvice::Random:
+				nativeAdvice = MADV_RANDOM;
+				break;
+			case MapAdvice::WillNeed:
+				nativeAdvice = MADV_WILLNEED;
+				break;
+			}
+
+			// Hints are best-effort, failure is not an error
+			::madvise(m_dataPtr + alignedOffset, length, nativeAdvice);
+			return *this;
+		}
+
+		// The returned slice points into the mapping and is only valid while this reader lives
+		BinaryReaderSlice
+		slice(size_t size)
+		{
+			BinaryReaderSlice ret(m_dataPtr + tell(), size);
+			seek(size, std::ios::cur);
+			return ret;
+		}
+
+	private:
+		void
+		unmap()
+		{
+			if (m_dataPtr != nullptr)
+				::munmap(m_dataPtr, m_size);
+			m_dataPtr = nullptr;
+		}
+	};
+};
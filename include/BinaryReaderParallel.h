@@ -0,0 +1,523 @@
+#pragma once
+
+#include "BinaryReader.h"
+#include "BinaryReaderExceptions.h"
+#include "BinaryReaderSimd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BinaryReader
+{
+	// Work-stealing thread pool
+	// Each worker owns a deque; it pops its own work from the back and steals from the front of others
+	// Create one and reuse it across reads, or use ThreadPool::shared()
+	class ThreadPool
+	{
+		struct Queue
+		{
+			std::mutex lock;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> m_queues;
+		std::vector<std::thread> m_threads;
+		std::mutex m_sleepLock;
+		std::condition_variable m_wake;
+		std::atomic<size_t> m_pending;
+		std::atomic<size_t> m_nextQueue;
+		bool m_stop;
+
+	public:
+		explicit ThreadPool(size_t threadCount = std::max(1u, std::thread::hardware_concurrency()))
+			: m_pending(0), m_nextQueue(0), m_stop(false)
+		{
+			threadCount = std::max<size_t>(1, threadCount);
+			for (size_t i = 0; i < threadCount; i++)
+				m_queues.push_back(std::make_unique<Queue>());
+			for (size_t i = 0; i < threadCount; i++)
+				m_threads.emplace_back([this, i] { _workerLoop(i); });
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_sleepLock);
+				m_stop = true;
+			}
+			m_wake.notify_all();
+			for (auto& thread : m_threads)
+				thread.join();
+		}
+
+		static ThreadPool&
+		shared()
+		{
+			static ThreadPool pool;
+			return pool;
+		}
+
+		size_t
+		size() const
+		{
+			return m_threads.size();
+		}
+
+		// Runs fn(0..taskCount-1) across the pool and blocks until all are done
+		// The calling thread also executes tasks, so nested use cannot deadlock. Once none are left to take,
+		//   it sleeps until the ones other threads picked up have finished
+		// The first exception thrown by any task is rethrown here
+		void
+		parallelFor(size_t taskCount, const std::function<void(size_t)>& fn)
+		{
+			if (taskCount == 0)
+				return;
+			if (taskCount == 1)
+			{
+				fn(0);
+				return;
+			}
+
+			// Guards `remaining` and `error`
+			std::mutex lock;
+			std::condition_variable finished;
+			size_t remaining = taskCount;
+			std::exception_ptr error;
+
+			auto run = [&](size_t task) {
+				std::exception_ptr thrown;
+				try
+				{
+					fn(task);
+				}
+				catch (...)
+				{
+					thrown = std::current_exception();
+				}
+
+				// Notified under the lock, so the caller cannot return and destroy it before this is done
+				std::lock_guard<std::mutex> guard(lock);
+				if (thrown && !error)
+					error = thrown;
+				if (--remaining == 0)
+					finished.notify_all();
+			};
+
+			for (size_t task = 0; task < taskCount; task++)
+				_push([&run, task] { run(task); });
+
+			// Help out while there are queued tasks, ours or anyone else's
+			while (_tryRunOne(m_nextQueue.load(std::memory_order_relaxed) % m_queues.size()))
+			{
+			}
+
+			std::unique_lock<std::mutex> guard(lock);
+			finished.wait(guard, [&] { return remaining == 0; });
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+	private:
+		void
+		_push(std::function<void()> task)
+		{
+			size_t index = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+			{
+				std::lock_guard<std::mutex> guard(m_queues[index]->lock);
+				m_queues[index]->tasks.push_back(std::move(task));
+			}
+			m_pending.fetch_add(1, std::memory_order_release);
+			// Lock so a worker between its pending check and wait() cannot miss this
+			{
+				std::lock_guard<std::mutex> guard(m_sleepLock);
+			}
+			m_wake.notify_one();
+		}
+
+		// Own queue from the back, then steal from the front of the others
+		bool
+		_tryRunOne(size_t home)
+		{
+			std::function<void()> task;
+			for (size_t i = 0; i < m_queues.size() && !task; i++)
+			{
+				Queue& queue = *m_queues[(home + i) % m_queues.size()];
+				std::lock_guard<std::mutex> guard(queue.lock);
+				if (queue.tasks.empty())
+					continue;
+				if (i == 0)
+				{
+					task = std::move(queue.tasks.back());
+					queue.tasks.pop_back();
+				}
+				else
+				{
+					task = std::move(queue.tasks.front());
+					queue.tasks.pop_front();
+				}
+			}
+
+			if (!task)
+				return false;
+			m_pending.fetch_sub(1, std::memory_order_acq_rel);
+			task();
+			return true;
+		}
+
+		void
+		_workerLoop(size_t home)
+		{
+			while (true)
+			{
+				if (_tryRunOne(home))
+					continue;
+
+				std::unique_lock<std::mutex> guard(m_sleepLock);
+				m_wake.wait(guard, [this] { return m_stop || m_pending.load(std::memory_order_acquire) > 0; });
+				if (m_stop && m_pending.load(std::memory_order_acquire) == 0)
+					return;
+			}
+		}
+	};
+
+	// Parallel array decoding
+	// Every slice is read with readBytesAt, so the reader must support positional reads.
+	//   The cursor is advanced past the whole array afterwards, like the serial versions
+	namespace Parallel
+	{
+		// Bytes per task, at least; arrays smaller than this are read as one task
+		constexpr size_t MIN_SLICE_BYTES = 256 * 1024;
+
+		inline size_t
+		_sliceCount(size_t totalBytes, ThreadPool& pool)
+		{
+			size_t slices = std::max<size_t>(1, totalBytes / MIN_SLICE_BYTES);
+			// A few slices per thread lets faster workers steal the remainder
+			return std::min(slices, pool.size() * 4);
+		}
+
+		// Calls fn(firstElement, elementCount) for each slice
+		inline void
+		_forSlices(size_t count, size_t elementSize, ThreadPool& pool, const std::function<void(size_t, size_t)>& fn)
+		{
+			size_t slices = _sliceCount(count * elementSize, pool);
+			size_t perSlice = (count + slices - 1) / slices;
+			pool.parallelFor(slices, [&](size_t slice) {
+				size_t first = slice * perSlice;
+				if (first >= count)
+					return;
+				fn(first, std::min(perSlice, count - first));
+			});
+		}
+
+		// Finds the lowest failing index across slices, so LimitException matches the serial read
+		template <typename T, typename Check>
+		inline void
+		_validate(T* dst, size_t count, ThreadPool& pool, Check&& check, const std::function<void(size_t)>& fail)
+		{
+			std::atomic<size_t> firstBad(std::numeric_limits<size_t>::max());
+			_forSlices(count, sizeof(T), pool, [&](size_t first, size_t n) {
+				// Slices past an already found failure cannot lower the index
+				if (first > firstBad.load(std::memory_order_relaxed))
+					return;
+				size_t bad = check(dst + first, n);
+				if (bad < n)
+				{
+					size_t index = first + bad;
+					size_t seen = firstBad.load(std::memory_order_relaxed);
+					while (index < seen && !firstBad.compare_exchange_weak(seen, index, std::memory_order_relaxed))
+					{
+					}
+				}
+			});
+
+			size_t index = firstBad.load();
+			if (index != std::numeric_limits<size_t>::max())
+				fail(index);
+		}
+
+		// The reader's failure statistics are private to BasicReader
+		struct Access
+		{
+			template <typename Reader, typename Exception>
+			static Exception
+			statFailure(Reader& reader, Exception&& e)
+			{
+				return reader._statFailure(std::move(e));
+			}
+		};
+
+		// Counted as a Safe failure like the serial reads, with the cursor left just past the failing element
+		template <typename Reader, typename Exception>
+		[[noreturn]] inline void
+		_failAt(Reader& reader, size_t start, size_t elementSize, size_t index, Exception&& e)
+		{
+			reader.seek(start + (index + 1) * elementSize, std::ios::beg);
+			throw Access::statFailure(reader, std::move(e));
+		}
+
+		// Floats fail in several ways, each with its own exception. Re-reading the failing element with the serial
+		//   Safe read throws exactly what it would have, and leaves the cursor just past the element
+		// Slices past the failure may already have been fixed up in place, so `reload(first, n)` loads everything
+		//   from the failing element on again, as read, like the serial read leaves it
+		template <typename Reader, typename Reload, typename Reread>
+		[[noreturn]] inline void
+		_failFloatAt(Reader& reader, size_t start, size_t elementSize, size_t index, size_t count, Reload&& reload, Reread&& reread)
+		{
+			reload(index, count - index);
+			reader.seek(start + index * elementSize, std::ios::beg);
+			reread();
+			throw std::logic_error("Serial read accepted an element the parallel check rejected");
+		}
+
+		// Loads elements [first, first + n) of the array at `start`
+		template <std::endian Order, typename T, typename Reader>
+		inline void
+		_loadSlice(Reader& reader, T* dst, size_t start, size_t first, size_t n)
+		{
+			reader.readBytesAt(dst + first, n * sizeof(T), start + first * sizeof(T));
+			Simd::toNativeArray<Order>(dst + first, n);
+		}
+
+		// Same in-place widening as BasicReader::readHalfArray, per slice
+		template <typename Reader>
+		inline void
+		_loadHalfSlice(Reader& reader, float* dst, size_t start, size_t first, size_t n)
+		{
+			uint16_t* raw = (uint16_t*)(dst + first) + n;
+			reader.readBytesAt(raw, n * sizeof(uint16_t), start + first * sizeof(uint16_t));
+			Simd::toNativeArray<std::endian::little>(raw, n);
+			Simd::halfToFloatArray(raw, dst + first, n);
+		}
+
+		// Checks and fixes up a slice in place, see Simd::fixFloats
+		template <typename T>
+		inline auto
+		_floatCheck(Simd::FloatKey<T> keyMin, Simd::FloatKey<T> keyMax, uint8_t flags)
+		{
+			return [=](T* data, size_t n) {
+				return Simd::fixFloats(data, n, keyMin, keyMax, flags & CONV_INF, flags & CONV_ZERO, flags & FAIL_SUBNORM);
+			};
+		}
+
+		// [exact, exact + 1 ULP), as in the serial reads
+		template <typename T>
+		inline Simd::FloatKey<T>
+		_keyAfter(T exact)
+		{
+			auto key = Simd::floatKey(exact);
+			return key == std::numeric_limits<decltype(key)>::max() ? key : key + 1;
+		}
+	};
+
+	template <typename T, typename Reader>
+	requires std::integral<T> || std::floating_point<T>
+	void
+	readScalarArrayParallel(Reader& reader, T* dst, size_t count, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		Parallel::_forSlices(count, sizeof(T), pool, [&](size_t first, size_t n) {
+			Parallel::_loadSlice<std::endian::little>(reader, dst, start, first, n);
+		});
+		reader.seek(start + count * sizeof(T), std::ios::beg);
+	}
+
+	template <typename T, typename Reader>
+	requires std::integral<T> || std::floating_point<T>
+	void
+	readScalarArrayBEParallel(Reader& reader, T* dst, size_t count, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		Parallel::_forSlices(count, sizeof(T), pool, [&](size_t first, size_t n) {
+			Parallel::_loadSlice<std::endian::big>(reader, dst, start, first, n);
+		});
+		reader.seek(start + count * sizeof(T), std::ios::beg);
+	}
+
+	template <typename T, typename Reader>
+	requires std::integral<T> && isSimpleComparable<T>
+	void
+	readScalarArraySafeParallel(Reader& reader, T* dst, size_t count, T min, T max, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readScalarArrayParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool,
+			[&](const T* data, size_t n) { return Simd::findOutOfRange(data, n, min, max); },
+			[&](size_t index) {
+				Parallel::_failAt(reader, start, sizeof(T), index, LimitException(dst[index], dst[index] < min ? min : max, index, debugMsg));
+			});
+	}
+
+	template <typename T, typename Reader>
+	requires std::integral<T> && isSimpleComparable<T>
+	void
+	readScalarArraySafeParallel(Reader& reader, T* dst, size_t count, T exact, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readScalarArrayParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool,
+			[&](const T* data, size_t n) { return Simd::findNotEqual(data, n, exact); },
+			[&](size_t index) {
+				Parallel::_failAt(reader, start, sizeof(T), index, LimitException(dst[index], exact, index, debugMsg));
+			});
+	}
+
+	template <typename T, typename Reader>
+	requires std::integral<T> && isSimpleComparable<T>
+	void
+	readScalarArrayBESafeParallel(Reader& reader, T* dst, size_t count, T min, T max, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readScalarArrayBEParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool,
+			[&](const T* data, size_t n) { return Simd::findOutOfRange(data, n, min, max); },
+			[&](size_t index) {
+				Parallel::_failAt(reader, start, sizeof(T), index, LimitException(dst[index], dst[index] < min ? min : max, index, debugMsg));
+			});
+	}
+
+	template <typename T, typename Reader>
+	requires std::integral<T> && isSimpleComparable<T>
+	void
+	readScalarArrayBESafeParallel(Reader& reader, T* dst, size_t count, T exact, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readScalarArrayBEParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool,
+			[&](const T* data, size_t n) { return Simd::findNotEqual(data, n, exact); },
+			[&](size_t index) {
+				Parallel::_failAt(reader, start, sizeof(T), index, LimitException(dst[index], exact, index, debugMsg));
+			});
+	}
+
+	template <typename T, typename Reader>
+	requires std::floating_point<T> && isSimpleComparable<T>
+	void
+	readScalarArraySafeParallel(Reader& reader, T* dst, size_t count, T min, T max, uint8_t flags, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readScalarArrayParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool, Parallel::_floatCheck<T>(Simd::floatKey(min), Simd::floatKey(max), flags),
+			[&](size_t index) {
+				Parallel::_failFloatAt(reader, start, sizeof(T), index, count,
+					[&](size_t first, size_t n) { Parallel::_loadSlice<std::endian::little>(reader, dst, start, first, n); },
+					[&] { reader.template readScalarSafe<T>(min, max, flags, debugMsg); });
+			});
+	}
+
+	template <typename T, typename Reader>
+	requires std::floating_point<T> && isSimpleComparable<T>
+	void
+	readScalarArraySafeParallel(Reader& reader, T* dst, size_t count, T exact, uint8_t flags, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readScalarArrayParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool, Parallel::_floatCheck<T>(Simd::floatKey(exact), Parallel::_keyAfter(exact), flags),
+			[&](size_t index) {
+				Parallel::_failFloatAt(reader, start, sizeof(T), index, count,
+					[&](size_t first, size_t n) { Parallel::_loadSlice<std::endian::little>(reader, dst, start, first, n); },
+					[&] { reader.template readScalarSafe<T>(exact, flags, debugMsg); });
+			});
+	}
+
+	template <typename T, typename Reader>
+	requires std::floating_point<T> && isSimpleComparable<T>
+	void
+	readScalarArrayBESafeParallel(Reader& reader, T* dst, size_t count, T min, T max, uint8_t flags, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readScalarArrayBEParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool, Parallel::_floatCheck<T>(Simd::floatKey(min), Simd::floatKey(max), flags),
+			[&](size_t index) {
+				Parallel::_failFloatAt(reader, start, sizeof(T), index, count,
+					[&](size_t first, size_t n) { Parallel::_loadSlice<std::endian::big>(reader, dst, start, first, n); },
+					[&] { reader.template readScalarBESafe<T>(min, max, flags, debugMsg); });
+			});
+	}
+
+	template <typename T, typename Reader>
+	requires std::floating_point<T> && isSimpleComparable<T>
+	void
+	readScalarArrayBESafeParallel(Reader& reader, T* dst, size_t count, T exact, uint8_t flags, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readScalarArrayBEParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool, Parallel::_floatCheck<T>(Simd::floatKey(exact), Parallel::_keyAfter(exact), flags),
+			[&](size_t index) {
+				Parallel::_failFloatAt(reader, start, sizeof(T), index, count,
+					[&](size_t first, size_t n) { Parallel::_loadSlice<std::endian::big>(reader, dst, start, first, n); },
+					[&] { reader.template readScalarBESafe<T>(exact, flags, debugMsg); });
+			});
+	}
+
+	template <typename Reader>
+	void
+	readHalfArrayParallel(Reader& reader, float* dst, size_t count, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		Parallel::_forSlices(count, sizeof(uint16_t), pool, [&](size_t first, size_t n) {
+			Parallel::_loadHalfSlice(reader, dst, start, first, n);
+		});
+		reader.seek(start + count * sizeof(uint16_t), std::ios::beg);
+	}
+
+	template <typename Reader>
+	void
+	readHalfArraySafeParallel(Reader& reader, float* dst, size_t count, float min, float max, uint8_t flags, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readHalfArrayParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool, Parallel::_floatCheck<float>(Simd::floatKey(min), Simd::floatKey(max), flags),
+			[&](size_t index) {
+				Parallel::_failFloatAt(reader, start, sizeof(uint16_t), index, count,
+					[&](size_t first, size_t n) { Parallel::_loadHalfSlice(reader, dst, start, first, n); },
+					[&] { reader.readHalfSafe(min, max, flags, debugMsg); });
+			});
+	}
+
+	template <typename Reader>
+	void
+	readHalfArraySafeParallel(Reader& reader, float* dst, size_t count, float exact, uint8_t flags, const DebugMessage& debugMsg, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		readHalfArrayParallel(reader, dst, count, pool);
+		Parallel::_validate(dst, count, pool, Parallel::_floatCheck<float>(Simd::floatKey(exact), Parallel::_keyAfter(exact), flags),
+			[&](size_t index) {
+				Parallel::_failFloatAt(reader, start, sizeof(uint16_t), index, count,
+					[&](size_t first, size_t n) { Parallel::_loadHalfSlice(reader, dst, start, first, n); },
+					[&] { reader.readHalfSafe(exact, flags, debugMsg); });
+			});
+	}
+
+	// Calls fn(record, index) for `count` fixed-size records of `stride` bytes
+	// `record` points at a private copy of the record's bytes, valid for the duration of the call
+	// Records are visited in parallel and in no particular order
+	template <typename Reader, typename Fn>
+	void
+	forEachRecordParallel(Reader& reader, size_t stride, size_t count, Fn&& fn, ThreadPool& pool = ThreadPool::shared())
+	{
+		size_t start = reader.tell();
+		Parallel::_forSlices(count, stride, pool, [&](size_t first, size_t n) {
+			std::vector<uint8_t> block(n * stride);
+			reader.readBytesAt(block.data(), block.size(), start + first * stride);
+			for (size_t i = 0; i < n; i++)
+				fn((const uint8_t*)block.data() + i * stride, first + i);
+		});
+		reader.seek(start + count * stride, std::ios::beg);
+	}
+};
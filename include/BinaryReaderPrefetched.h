@@ -0,0 +1,412 @@
+#pragma once
+
+#include "BinaryReader.h"
+#include "BinaryReaderExceptions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BinaryReader
+{
+	// Streaming file reader that keeps several blocks ahead of the cursor loading on a background thread (POSIX)
+	// Parsing and disk I/O overlap; reads only block when the cursor catches up with the prefetcher
+	// A seek that leaves the prefetched range discards the queued blocks and restarts prefetch at the new position
+	// Each restart waits for a whole block, so random access is better served by BinaryReaderWindowed or BinaryReaderMapped
+	class BinaryReaderPrefetched : public BinaryReader
+	{
+		static constexpr size_t BLOCK_ALIGN = 4096;
+
+		enum class SlotState
+		{
+			Empty,
+			// Claimed for a block, waiting for the prefetch thread
+			Queued,
+			Loading,
+			Ready
+		};
+
+		struct BlockDeleter
+		{
+			void
+			operator()(uint8_t* ptr) const
+			{
+				::operator delete[](ptr, std::align_val_t(BLOCK_ALIGN));
+			}
+		};
+
+		struct Slot
+		{
+			std::unique_ptr<uint8_t[], BlockDeleter> data;
+			SlotState state = SlotState::Empty;
+			// File offset of data[0], and how many bytes are valid
+			size_t start = 0;
+			size_t fill = 0;
+			// Prefetch generation the load was issued under. Stale loads are dropped
+			uint64_t generation = 0;
+			std::exception_ptr error;
+		};
+
+		int m_fd;
+		size_t m_length;
+		size_t m_curPos;
+		size_t m_blockSize;
+
+		// Owned by the consumer: the Ready slot the cursor is in, readable without locking
+		Slot* m_current;
+
+		// Everything below is shared with the prefetch thread
+		std::vector<Slot> m_slots;
+		std::mutex m_lock;
+		std::condition_variable m_wakeWorker;
+		std::condition_variable m_wakeReader;
+		size_t m_nextOffset;
+		uint64_t m_generation;
+		bool m_stopping;
+		std::thread m_worker;
+
+		void
+		readBytes(void* dst, int count) override
+		{
+			if (m_current != nullptr && m_curPos >= m_current->start && m_curPos + count <= m_current->start + m_current->fill)
+			{
+				std::memcpy(dst, m_current->data.get() + (m_curPos - m_current->start), count);
+				m_curPos += count;
+				return;
+			}
+			_readSlow((uint8_t*)dst, count);
+		}
+
+		// Exposes the rest of the current block, waiting for it if needed
+		const uint8_t*
+		cursorPtr(size_t& remaining) override
+		{
+			if (m_curPos >= m_length)
+			{
+				remaining = 0;
+				return nullptr;
+			}
+			if (!_inCurrent(m_curPos))
+				_acquire(m_curPos);
+
+			remaining = m_current->start + m_current->fill - m_curPos;
+			return m_current->data.get() + (m_curPos - m_current->start);
+		}
+
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+		static constexpr size_t DEFAULT_BLOCK_COUNT = 4;
+
+		// `blockSize` is rounded up to a multiple of 4 KiB; at least 2 blocks are used
+		// One block is held by the cursor while the rest load ahead of it
+		BinaryReaderPrefetched(const std::string& filePath, size_t blockSize = DEFAULT_BLOCK_SIZE, size_t blockCount = DEFAULT_BLOCK_COUNT)
+			: m_fd(-1), m_length(0), m_curPos(0), m_blockSize(0), m_current(nullptr),
+			  m_nextOffset(0), m_generation(0), m_stopping(false)
+		{
+			m_fd = ::open(filePath.c_str(), O_RDONLY);
+			if (m_fd < 0)
+				throw std::runtime_error("File does not exist");
+
+			struct stat fileStat;
+			if (::fstat(m_fd, &fileStat) != 0)
+			{
+				::close(m_fd);
+				throw std::runtime_error("Cannot stat file");
+			}
+			m_length = (size_t)fileStat.st_size;
+
+			m_blockSize = std::max(BLOCK_ALIGN, (blockSize + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN);
+			m_slots.resize(std::max<size_t>(blockCount, 2));
+			for (Slot& slot : m_slots)
+				slot.data.reset((uint8_t*)::operator new[](m_blockSize, std::align_val_t(BLOCK_ALIGN)));
+
+#ifdef POSIX_FADV_SEQUENTIAL
+			::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+			m_worker = std::thread([this] { _prefetchLoop(); });
+		}
+
+		BinaryReaderPrefetched(const BinaryReaderPrefetched&) = delete;
+		BinaryReaderPrefetched& operator=(const BinaryReaderPrefetched&) = delete;
+
+		~BinaryReaderPrefetched()
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_lock);
+				m_stopping = true;
+			}
+			m_wakeWorker.notify_all();
+			m_worker.join();
+			::close(m_fd);
+		}
+
+		size_t
+		getLength() override
+		{
+			return m_length;
+		}
+
+		BinaryReaderPrefetched&
+		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur) override
+		{
+			_statSeek(offset, way);
+			switch (way)
+			{
+			case std::ios_base::beg:
+				m_curPos = offset;
+				break;
+			case std::ios_base::cur:
+				m_curPos += offset;
+				break;
+			case std::ios_base::end:
+				m_curPos = m_length + offset;
+				break;
+			}
+
+			// Restart right away so the new range is loading while the caller does other work
+			if (!_inCurrent(m_curPos) && m_curPos < m_length)
+			{
+				std::lock_guard<std::mutex> guard(m_lock);
+				if (_findSlot(m_curPos) == nullptr)
+					_restart(m_curPos);
+			}
+			return *this;
+		}
+
+		size_t
+		tell() override
+		{
+			return m_curPos;
+		}
+
+		// Bypasses the prefetch queue, which belongs to the cursor
+		void
+		readBytesAt(void* dst, size_t count, size_t offset) const override
+		{
+			if (offset > m_length || count > m_length - offset)
+				throw std::out_of_range("Positional read out of bounds");
+			_pread((uint8_t*)dst, count, offset);
+		}
+
+		size_t
+		getBlockSize() const
+		{
+			return m_blockSize;
+		}
+
+		size_t
+		getBlockCount() const
+		{
+			return m_slots.size();
+		}
+
+	private:
+		bool
+		_inCurrent(size_t pos) const
+		{
+			return m_current != nullptr && pos >= m_current->start && pos < m_current->start + m_current->fill;
+		}
+
+		void
+		_readSlow(uint8_t* dst, size_t count)
+		{
+			if (m_curPos + count > m_length)
+				throw std::runtime_error("Read past end of file");
+
+			while (count > 0)
+			{
+				if (!_inCurrent(m_curPos))
+					_acquire(m_curPos);
+
+				size_t available = std::min(count, m_current->start + m_current->fill - m_curPos);
+				std::memcpy(dst, m_current->data.get() + (m_curPos - m_current->start), available);
+				dst += available;
+				count -= available;
+				m_curPos += available;
+			}
+		}
+
+		// Makes the block holding `pos` current, waiting on the prefetcher if it is still loading
+		// Blocks behind it are handed back to the prefetcher
+		void
+		_acquire(size_t pos)
+		{
+			std::unique_lock<std::mutex> guard(m_lock);
+			m_current = nullptr;
+
+			Slot* slot = _findSlot(pos);
+			if (slot == nullptr)
+			{
+				_restart(pos);
+				slot = _findSlot(pos);
+			}
+
+			m_wakeReader.wait(guard, [&] { return slot->state == SlotState::Ready; });
+			if (slot->error)
+			{
+				std::exception_ptr error = slot->error;
+				slot->error = nullptr;
+				slot->state = SlotState::Empty;
+				std::rethrow_exception(error);
+			}
+
+			bool released = false;
+			for (Slot& other : m_slots)
+			{
+				if ((other.state == SlotState::Ready || other.state == SlotState::Queued) && other.start < slot->start)
+				{
+					other.state = SlotState::Empty;
+					released = true;
+				}
+			}
+			if (released)
+				m_wakeWorker.notify_one();
+
+			m_current = slot;
+		}
+
+		// Non-empty slot of the current generation that covers `pos`. Caller holds m_lock
+		Slot*
+		_findSlot(size_t pos)
+		{
+			for (Slot& slot : m_slots)
+			{
+				if (slot.state != SlotState::Empty && slot.generation == m_generation &&
+					pos >= slot.start && pos < slot.start + m_blockSize)
+					return &slot;
+			}
+			return nullptr;
+		}
+
+		// Drops every queued block and starts prefetching at the block holding `pos`
+		// The block itself is claimed here so the caller always finds it. Caller holds m_lock
+		void
+		_restart(size_t pos)
+		{
+			m_generation++;
+			m_current = nullptr;
+			for (Slot& slot : m_slots)
+			{
+				if (slot.state != SlotState::Loading)
+				{
+					slot.state = SlotState::Empty;
+					slot.error = nullptr;
+				}
+			}
+
+			m_nextOffset = pos - (pos % m_blockSize);
+			_claimNext();
+			m_wakeWorker.notify_one();
+		}
+
+		// Queues the next block into an empty slot. Caller holds m_lock
+		// A load still in flight from an old generation keeps its slot until it finishes
+		Slot*
+		_claimNext()
+		{
+			if (m_nextOffset >= m_length)
+				return nullptr;
+
+			for (Slot& slot : m_slots)
+			{
+				if (slot.state == SlotState::Empty)
+				{
+					slot.state = SlotState::Queued;
+					slot.start = m_nextOffset;
+					slot.fill = std::min(m_blockSize, m_length - m_nextOffset);
+					slot.generation = m_generation;
+					slot.error = nullptr;
+					m_nextOffset += m_blockSize;
+					return &slot;
+				}
+			}
+			return nullptr;
+		}
+
+		// Lowest queued block of the current generation. Caller holds m_lock
+		Slot*
+		_nextQueued()
+		{
+			Slot* next = nullptr;
+			for (Slot& slot : m_slots)
+			{
+				if (slot.state == SlotState::Queued && (next == nullptr || slot.start < next->start))
+					next = &slot;
+			}
+			return next;
+		}
+
+		void
+		_prefetchLoop()
+		{
+			std::unique_lock<std::mutex> guard(m_lock);
+			while (!m_stopping)
+			{
+				Slot* slot = _nextQueued();
+				if (slot == nullptr)
+					slot = _claimNext();
+				if (slot == nullptr)
+				{
+					m_wakeWorker.wait(guard);
+					continue;
+				}
+
+				slot->state = SlotState::Loading;
+				size_t start = slot->start;
+				size_t fill = slot->fill;
+				uint64_t generation = slot->generation;
+				std::exception_ptr error;
+
+				guard.unlock();
+				try
+				{
+					_pread(slot->data.get(), fill, start);
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+				guard.lock();
+
+				if (generation != m_generation)
+					slot->state = SlotState::Empty;
+				else
+				{
+					slot->error = error;
+					slot->state = SlotState::Ready;
+				}
+				m_wakeReader.notify_all();
+			}
+		}
+
+		void
+		_pread(uint8_t* dst, size_t count, size_t offset) const
+		{
+			while (count > 0)
+			{
+				ssize_t got = ::pread(m_fd, dst, count, (off_t)offset);
+				if (got < 0 && errno == EINTR)
+					continue;
+				if (got <= 0)
+					throw std::runtime_error("Failed to read file");
+				dst += got;
+				count -= (size_t)got;
+				offset += (size_t)got;
+			}
+		}
+	};
+};
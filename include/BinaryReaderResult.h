@@ -0,0 +1,84 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <version>
+
+#ifdef __cpp_lib_expected
+	#include <expected>
+	#define BINARYREADER_HAS_EXPECTED
+#endif
+
+namespace BinaryReader
+{
+	// Message for a failed Safe read. Nothing is built unless the read actually fails
+	// Takes a string literal, std::string_view, std::string, or a callable returning a string
+	//   reader.readScalarSafe<uint32_t>(0, 16, [&] { return "Bad mip count in " + name; });
+	// Only refers to its source, so it must not outlive the call it is passed to
+	class DebugMessage
+	{
+		std::string_view m_text;
+		const void* m_callable;
+		std::string (*m_invoke)(const void*);
+
+	public:
+		DebugMessage(const char* text) : m_text(text), m_callable(nullptr), m_invoke(nullptr) {};
+		DebugMessage(std::string_view text) : m_text(text), m_callable(nullptr), m_invoke(nullptr) {};
+		DebugMessage(const std::string& text) : m_text(text), m_callable(nullptr), m_invoke(nullptr) {};
+
+		template <class F>
+		requires std::invocable<const F&> && std::constructible_from<std::string, std::invoke_result_t<const F&>> &&
+			(!std::convertible_to<const F&, std::string_view>)
+		DebugMessage(const F& callable)
+			: m_text(), m_callable(&callable),
+			  m_invoke([](const void* fn) { return std::string((*(const F*)fn)()); })
+		{
+		}
+
+		std::string
+		str() const
+		{
+			return m_invoke != nullptr ? m_invoke(m_callable) : std::string(m_text);
+		}
+
+		// So it can be handed straight to the exceptions
+		operator std::string() const
+		{
+			return str();
+		}
+	};
+
+	enum class ReadErrorKind
+	{
+		// value < limit
+		BelowMin,
+		// value >= limit
+		AboveMax,
+		// value != limit
+		NotExact,
+		// Infinity without CONV_INF
+		Infinite,
+		NaN,
+		// Sub-normal with FAIL_SUBNORM
+		Subnormal
+	};
+
+	// Why a tryRead* call failed. `index` is the failing element for arrays, 0 for scalars
+	template <typename T>
+	struct ReadError
+	{
+		ReadErrorKind kind;
+		size_t index;
+		T value;
+		T limit;
+	};
+
+#ifdef BINARYREADER_HAS_EXPECTED
+	// Result of the tryRead* family. Arrays return ReadResult<T, void>
+	template <typename T, typename Value = T>
+	using ReadResult = std::expected<Value, ReadError<T>>;
+#endif
+};
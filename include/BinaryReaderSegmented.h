@@ -0,0 +1,524 @@
+#pragma once
+
+#include "BinaryReader.h"
+#include "BinaryReaderBlockCache.h"
+#include "BinaryReaderExceptions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BinaryReader
+{
+	class BinaryReaderSegmented;
+
+	// An open, read-only file descriptor and the file's length, identity and modification time (ns) at open time
+	// Shared between the pool and the readers using it; closed when the last of them lets go
+	struct FileHandle
+	{
+		int fd;
+		size_t length;
+		uint64_t device;
+		uint64_t inode;
+		int64_t mtime;
+
+		FileHandle(int fd, size_t length, uint64_t device, uint64_t inode, int64_t mtime)
+			: fd(fd), length(length), device(device), inode(inode), mtime(mtime) {};
+		FileHandle(const FileHandle&) = delete;
+		FileHandle& operator=(const FileHandle&) = delete;
+
+		~FileHandle()
+		{
+			::close(fd);
+		}
+	};
+
+	// A byte range of one file. WHOLE_FILE runs to the end of the file
+	struct Segment
+	{
+		static constexpr size_t WHOLE_FILE = std::numeric_limits<size_t>::max();
+
+		std::string path;
+		size_t offset = 0;
+		size_t length = WHOLE_FILE;
+	};
+
+	// Keeps up to `capacity` files open, evicting the least recently used (POSIX)
+	// Opening a reader through the pool reuses the descriptor instead of opening and stat-ing the file again
+	// An evicted handle stays open until the readers still holding it are done with it
+	// Readers opened through a pool with a BlockCache read through the cache
+	// Thread-safe. Readers keep a pointer to their pool, so it must outlive them
+	class FileHandlePool
+	{
+		struct Entry
+		{
+			std::string path;
+			std::shared_ptr<const FileHandle> handle;
+		};
+
+		mutable std::mutex m_lock;
+		size_t m_capacity;
+		BlockCache* m_cache;
+		// Most recently used first
+		std::list<Entry> m_lru;
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+		uint64_t m_hits;
+		uint64_t m_misses;
+
+	public:
+		static constexpr size_t DEFAULT_CAPACITY = 64;
+
+		explicit FileHandlePool(size_t capacity = DEFAULT_CAPACITY, BlockCache* cache = nullptr)
+			: m_capacity(std::max<size_t>(capacity, 1)), m_cache(cache), m_hits(0), m_misses(0)
+		{
+		}
+
+		FileHandlePool(const FileHandlePool&) = delete;
+		FileHandlePool& operator=(const FileHandlePool&) = delete;
+
+		static FileHandlePool&
+		shared()
+		{
+			static FileHandlePool pool;
+			return pool;
+		}
+
+		std::shared_ptr<const FileHandle>
+		acquire(const std::string& path)
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_lock);
+				auto it = m_index.find(path);
+				if (it != m_index.end())
+				{
+					m_hits++;
+					m_lru.splice(m_lru.begin(), m_lru, it->second);
+					return it->second->handle;
+				}
+				m_misses++;
+			}
+
+			// Opened outside the lock so a slow open doesn't stall hits on other files
+			std::shared_ptr<const FileHandle> handle = _open(path);
+
+			std::lock_guard<std::mutex> guard(m_lock);
+			auto it = m_index.find(path);
+			// Another thread opened it meanwhile; theirs wins and ours closes on return
+			if (it != m_index.end())
+			{
+				m_lru.splice(m_lru.begin(), m_lru, it->second);
+				return it->second->handle;
+			}
+
+			m_lru.push_front(Entry{ path, handle });
+			m_index.emplace(path, m_lru.begin());
+			while (m_lru.size() > m_capacity)
+			{
+				m_index.erase(m_lru.back().path);
+				m_lru.pop_back();
+			}
+			return handle;
+		}
+
+		// Reader factories, defined after BinaryReaderSegmented
+		BinaryReaderSegmented open(const std::string& path, size_t offset = 0, size_t length = Segment::WHOLE_FILE);
+		BinaryReaderSegmented open(std::vector<Segment> segments);
+
+		// Closes every pooled handle not in use by a reader
+		void
+		clear()
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_index.clear();
+			m_lru.clear();
+		}
+
+		size_t
+		size() const
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			return m_lru.size();
+		}
+
+		size_t
+		capacity() const
+		{
+			return m_capacity;
+		}
+
+		BlockCache*
+		cache() const
+		{
+			return m_cache;
+		}
+
+		// acquire() calls that found the file already open, and those that had to open it
+		uint64_t
+		hits() const
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			return m_hits;
+		}
+
+		uint64_t
+		misses() const
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			return m_misses;
+		}
+
+	private:
+		static std::shared_ptr<const FileHandle>
+		_open(const std::string& path)
+		{
+			int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				throw std::runtime_error("File does not exist");
+
+			struct stat fileStat;
+			if (::fstat(fd, &fileStat) != 0)
+			{
+				::close(fd);
+				throw std::runtime_error("Cannot stat file");
+			}
+			return std::make_shared<const FileHandle>(fd, (size_t)fileStat.st_size, (uint64_t)fileStat.st_dev, (uint64_t)fileStat.st_ino,
+				BlockCache::modifiedNs(fileStat));
+		}
+	};
+
+	// Presents a list of files, or ranges of files, as one contiguous stream (POSIX)
+	// Handles come from a FileHandlePool, and reads are served from a small window refilled with pread
+	// If the pool has a BlockCache, the window is instead the cached block under the cursor, shared with other readers
+	//   Each part then keeps the handle it was opened with, and its blocks are only ever loaded from that handle
+	// A window never spans two segments; reads that cross a boundary are split
+	class BinaryReaderSegmented : public BinaryReader
+	{
+		struct Part
+		{
+			std::string path;
+			// Where the part starts in its file, and in the logical stream
+			size_t fileOffset;
+			size_t start;
+			size_t length;
+			// The BlockCache id, when cached, and the handle it was acquired for. Blocks are loaded from that
+			//   handle only, so a file replaced since can't put its bytes under this id
+			BlockCache::FileLease file;
+			std::shared_ptr<const FileHandle> handle;
+		};
+
+		FileHandlePool* m_pool;
+		BlockCache* m_cache;
+		std::vector<Part> m_parts;
+		size_t m_length;
+		size_t m_curPos;
+		// Points into m_window, or into m_block when cached
+		const uint8_t* m_windowPtr;
+		std::unique_ptr<uint8_t[]> m_window;
+		std::shared_ptr<const BlockCache::Block> m_block;
+		size_t m_windowSize;
+		// Logical offset of m_windowPtr[0], and how many bytes of the window are valid
+		size_t m_windowStart;
+		size_t m_windowFill;
+		// The handle of the part the window was last filled from, so refills don't go back to the pool
+		size_t m_handlePart;
+		std::shared_ptr<const FileHandle> m_handle;
+
+		void
+		readBytes(void* dst, int count) override
+		{
+			if (m_curPos >= m_windowStart && m_curPos + count <= m_windowStart + m_windowFill)
+			{
+				std::memcpy(dst, m_windowPtr + (m_curPos - m_windowStart), count);
+				m_curPos += count;
+				return;
+			}
+			_readSlow((uint8_t*)dst, count);
+		}
+
+		// Exposes the rest of the window, refilling first if the cursor has left it
+		const uint8_t*
+		cursorPtr(size_t& remaining) override
+		{
+			if (m_curPos >= m_length)
+			{
+				remaining = 0;
+				return nullptr;
+			}
+			if (m_curPos < m_windowStart || m_curPos >= m_windowStart + m_windowFill)
+				_refill();
+
+			remaining = m_windowStart + m_windowFill - m_curPos;
+			return m_windowPtr + (m_curPos - m_windowStart);
+		}
+
+	public:
+		static constexpr size_t DEFAULT_WINDOW_SIZE = 64 * 1024;
+
+		BinaryReaderSegmented()
+			: m_pool(nullptr), m_cache(nullptr), m_parts(), m_length(0), m_curPos(0), m_windowPtr(nullptr), m_window(), m_block(),
+			  m_windowSize(0), m_windowStart(0), m_windowFill(0), m_handlePart(0), m_handle()
+		{
+		}
+
+		// Segments past the end of their file throw out_of_range
+		// `windowSize` is unused when the pool has a BlockCache, whose blocks are the window
+		BinaryReaderSegmented(std::vector<Segment> segments, FileHandlePool& pool = FileHandlePool::shared(), size_t windowSize = DEFAULT_WINDOW_SIZE)
+			: m_pool(&pool), m_cache(pool.cache()), m_parts(), m_length(0), m_curPos(0), m_windowPtr(nullptr), m_window(), m_block(),
+			  m_windowSize(std::max<size_t>(windowSize, 1)), m_windowStart(0), m_windowFill(0), m_handlePart(0), m_handle()
+		{
+			m_parts.reserve(segments.size());
+			for (Segment& segment : segments)
+			{
+				std::shared_ptr<const FileHandle> handle = pool.acquire(segment.path);
+				if (segment.offset > handle->length)
+					throw std::out_of_range("Segment starts past end of file");
+				size_t length = std::min(segment.length, handle->length - segment.offset);
+				if (segment.length != Segment::WHOLE_FILE && length != segment.length)
+					throw std::out_of_range("Segment runs past end of file");
+
+				// Empty parts would only get in the way of the lookup
+				BlockCache::FileLease file = m_cache != nullptr ? m_cache->acquireFile(handle->device, handle->inode, handle->length, handle->mtime)
+					: BlockCache::FileLease();
+				if (length > 0)
+					m_parts.push_back(Part{ std::move(segment.path), segment.offset, m_length, length, std::move(file), m_cache != nullptr ? handle : nullptr });
+				m_length += length;
+
+				// Part 0's handle is already at hand, which saves a pool lookup on the first read
+				if (m_handle == nullptr && length > 0)
+					m_handle = std::move(handle);
+			}
+
+			if (m_cache != nullptr)
+			{
+				m_windowSize = m_cache->blockSize();
+				return;
+			}
+			// Small entries don't need a full window
+			m_windowSize = std::min(m_windowSize, std::max<size_t>(m_length, 1));
+			m_window = std::make_unique_for_overwrite<uint8_t[]>(m_windowSize);
+			m_windowPtr = m_window.get();
+		}
+
+		BinaryReaderSegmented(BinaryReaderSegmented&&) = default;
+		BinaryReaderSegmented& operator=(BinaryReaderSegmented&&) = default;
+
+		size_t
+		getLength() override
+		{
+			return m_length;
+		}
+
+		BinaryReaderSegmented&
+		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur) override
+		{
+			_statSeek(offset, way);
+			switch (way)
+			{
+			case std::ios_base::beg:
+				m_curPos = offset;
+				break;
+			case std::ios_base::cur:
+				m_curPos += offset;
+				break;
+			case std::ios_base::end:
+				m_curPos = m_length + offset;
+				break;
+			}
+			return *this;
+		}
+
+		size_t
+		tell() override
+		{
+			return m_curPos;
+		}
+
+		// Bypasses the window, which belongs to the cursor. Uncached, handles come straight from the pool
+		void
+		readBytesAt(void* dst, size_t count, size_t offset) const override
+		{
+			if (offset > m_length || count > m_length - offset)
+				throw std::out_of_range("Positional read out of bounds");
+
+			uint8_t* out = (uint8_t*)dst;
+			_forParts(offset, count, [&](size_t part, size_t fileOffset, size_t n) {
+				const Part& p = m_parts[part];
+				if (m_cache == nullptr)
+				{
+					std::shared_ptr<const FileHandle> handle = m_pool->acquire(p.path);
+					_pread(handle->fd, out, n, fileOffset);
+					out += n;
+					return;
+				}
+
+				m_cache->read(p.file.id(), out, n, fileOffset, [&](uint8_t* blockDst, size_t size, uint64_t index) {
+					return _loadBlock(*p.handle, index, blockDst, size);
+				});
+				out += n;
+			});
+		}
+
+		size_t
+		getSegmentCount() const
+		{
+			return m_parts.size();
+		}
+
+	private:
+		void
+		_readSlow(uint8_t* dst, size_t count)
+		{
+			if (m_curPos > m_length || count > m_length - m_curPos)
+				throw std::runtime_error("Read past end of data");
+
+			// Large reads bypass the window entirely, unless it is the shared cache
+			if (count >= m_windowSize && m_cache == nullptr)
+			{
+				_forParts(m_curPos, count, [&](size_t part, size_t fileOffset, size_t n) {
+					_pread(_handle(part).fd, dst, n, fileOffset);
+					dst += n;
+				});
+				m_curPos += count;
+				return;
+			}
+
+			while (count > 0)
+			{
+				if (m_curPos < m_windowStart || m_curPos >= m_windowStart + m_windowFill)
+					_refill();
+
+				size_t available = std::min(count, m_windowStart + m_windowFill - m_curPos);
+				std::memcpy(dst, m_windowPtr + (m_curPos - m_windowStart), available);
+				dst += available;
+				count -= available;
+				m_curPos += available;
+			}
+		}
+
+		// Fills the window from the cursor up to the end of the cursor's part
+		// Cached, the window is whatever of the cursor's block lies inside the part
+		void
+		_refill()
+		{
+			size_t part = _partAt(m_curPos);
+			const Part& p = m_parts[part];
+			size_t offsetInPart = m_curPos - p.start;
+			m_windowFill = 0;
+
+			if (m_cache != nullptr)
+			{
+				size_t fileOffset = p.fileOffset + offsetInPart;
+				uint64_t index = fileOffset / m_windowSize;
+				size_t blockStart = index * m_windowSize;
+				m_block = m_cache->get(p.file.id(), index, [&](uint8_t* dst, size_t size) {
+					return _loadBlock(*p.handle, index, dst, size);
+				});
+
+				size_t first = std::max(blockStart, p.fileOffset);
+				size_t last = std::min(blockStart + m_block->size, p.fileOffset + p.length);
+				// The file shrank since it was opened
+				if (last <= fileOffset)
+					throw std::runtime_error("Failed to read file");
+				m_windowPtr = m_block->data.get() + (first - blockStart);
+				m_windowStart = p.start + (first - p.fileOffset);
+				m_windowFill = last - first;
+				return;
+			}
+
+			m_windowStart = m_curPos;
+			size_t fill = std::min(m_windowSize, p.length - offsetInPart);
+			_pread(_handle(part).fd, m_window.get(), fill, p.fileOffset + offsetInPart);
+			m_windowFill = fill;
+		}
+
+		// Block `index` of the file, as much of it as the file has
+		static size_t
+		_loadBlock(const FileHandle& handle, uint64_t index, uint8_t* dst, size_t blockSize)
+		{
+			size_t offset = index * blockSize;
+			size_t size = offset < handle.length ? std::min(blockSize, handle.length - offset) : 0;
+			_pread(handle.fd, dst, size, offset);
+			return size;
+		}
+
+		const FileHandle&
+		_handle(size_t part)
+		{
+			if (m_handle == nullptr || m_handlePart != part)
+			{
+				m_handle = m_pool->acquire(m_parts[part].path);
+				m_handlePart = part;
+			}
+			return *m_handle;
+		}
+
+		// Index of the part holding logical offset `offset`, which must be < m_length
+		size_t
+		_partAt(size_t offset) const
+		{
+			auto it = std::upper_bound(m_parts.begin(), m_parts.end(), offset,
+				[](size_t value, const Part& part) { return value < part.start; });
+			return (size_t)(it - m_parts.begin()) - 1;
+		}
+
+		// Calls fn(part, fileOffset, n) for each piece of [offset, offset + count), in order
+		template <typename Fn>
+		void
+		_forParts(size_t offset, size_t count, Fn&& fn) const
+		{
+			if (count == 0)
+				return;
+			for (size_t part = _partAt(offset); count > 0; part++)
+			{
+				const Part& p = m_parts[part];
+				size_t offsetInPart = offset - p.start;
+				size_t n = std::min(count, p.length - offsetInPart);
+				fn(part, p.fileOffset + offsetInPart, n);
+				offset += n;
+				count -= n;
+			}
+		}
+
+		static void
+		_pread(int fd, uint8_t* dst, size_t count, size_t offset)
+		{
+			while (count > 0)
+			{
+				ssize_t got = ::pread(fd, dst, count, (off_t)offset);
+				if (got < 0 && errno == EINTR)
+					continue;
+				if (got <= 0)
+					throw std::runtime_error("Failed to read file");
+				dst += got;
+				count -= (size_t)got;
+				offset += (size_t)got;
+			}
+		}
+	};
+
+	inline BinaryReaderSegmented
+	FileHandlePool::open(const std::string& path, size_t offset, size_t length)
+	{
+		return BinaryReaderSegmented({ Segment{ path, offset, length } }, *this);
+	}
+
+	inline BinaryReaderSegmented
+	FileHandlePool::open(std::vector<Segment> segments)
+	{
+		return BinaryReaderSegmented(std::move(segments), *this);
+	}
+};
@@ -0,0 +1,855 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#ifdef _MSC_VER
+	#include <stdlib.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	// Kernels are compiled per-function with target attributes and picked at runtime
+	#define BINARYREADER_X86_SIMD 1
+#endif
+
+namespace BinaryReader
+{
+	namespace Simd
+	{
+		//////////////////////////////////////////////////////////////////////////////
+		// CPU features
+
+#ifdef BINARYREADER_X86_SIMD
+		inline bool
+		hasSSSE3()
+		{
+			static const bool supported = __builtin_cpu_supports("ssse3");
+			return supported;
+		}
+
+		inline bool
+		hasAVX2()
+		{
+			static const bool supported = __builtin_cpu_supports("avx2");
+			return supported;
+		}
+
+		inline bool
+		hasSSE2()
+		{
+			static const bool supported = __builtin_cpu_supports("sse2");
+			return supported;
+		}
+
+		inline bool
+		hasF16C()
+		{
+			static const bool supported = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+			return supported;
+		}
+#endif
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Byte swapping
+
+		inline uint16_t
+		bswap16(uint16_t v)
+		{
+#ifdef _MSC_VER
+			return _byteswap_ushort(v);
+#else
+			return __builtin_bswap16(v);
+#endif
+		}
+
+		inline uint32_t
+		bswap32(uint32_t v)
+		{
+#ifdef _MSC_VER
+			return _byteswap_ulong(v);
+#else
+			return __builtin_bswap32(v);
+#endif
+		}
+
+		inline uint64_t
+		bswap64(uint64_t v)
+		{
+#ifdef _MSC_VER
+			return _byteswap_uint64(v);
+#else
+			return __builtin_bswap64(v);
+#endif
+		}
+
+		template <size_t Size>
+		inline void
+		_byteSwapScalar(uint8_t* data, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				uint8_t* elem = data + i * Size;
+				if constexpr (Size == 2)
+				{
+					uint16_t v;
+					std::memcpy(&v, elem, 2);
+					v = bswap16(v);
+					std::memcpy(elem, &v, 2);
+				}
+				else if constexpr (Size == 4)
+				{
+					uint32_t v;
+					std::memcpy(&v, elem, 4);
+					v = bswap32(v);
+					std::memcpy(elem, &v, 4);
+				}
+				else if constexpr (Size == 8)
+				{
+					uint64_t v;
+					std::memcpy(&v, elem, 8);
+					v = bswap64(v);
+					std::memcpy(elem, &v, 8);
+				}
+				else
+				{
+					for (size_t lo = 0, hi = Size - 1; lo < hi; lo++, hi--)
+					{
+						uint8_t tmp = elem[lo];
+						elem[lo] = elem[hi];
+						elem[hi] = tmp;
+					}
+				}
+			}
+		}
+
+#ifdef BINARYREADER_X86_SIMD
+		// pshufb control that reverses each `Size`-byte element of a 16-byte lane
+		template <size_t Size>
+		inline __m128i
+		_swapMask128()
+		{
+			alignas(16) uint8_t mask[16];
+			for (int i = 0; i < 16; i++)
+				mask[i] = (uint8_t)((i / Size) * Size + (Size - 1 - i % Size));
+			return _mm_load_si128((const __m128i*)mask);
+		}
+
+		// Returns the number of elements swapped; the caller finishes the tail
+		template <size_t Size>
+		[[gnu::target("ssse3")]] inline size_t
+		_byteSwapSSSE3(uint8_t* data, size_t count)
+		{
+			const __m128i mask = _swapMask128<Size>();
+			const size_t perVec = 16 / Size;
+			size_t i = 0;
+			for (; i + perVec <= count; i += perVec)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i*)(data + i * Size));
+				_mm_storeu_si128((__m128i*)(data + i * Size), _mm_shuffle_epi8(v, mask));
+			}
+			return i;
+		}
+
+		template <size_t Size>
+		[[gnu::target("avx2")]] inline size_t
+		_byteSwapAVX2(uint8_t* data, size_t count)
+		{
+			// vpshufb shuffles within each 128-bit lane, so the same control is used twice
+			const __m128i half = _swapMask128<Size>();
+			const __m256i mask = _mm256_broadcastsi128_si256(half);
+			const size_t perVec = 32 / Size;
+			size_t i = 0;
+			for (; i + perVec * 2 <= count; i += perVec * 2)
+			{
+				__m256i a = _mm256_loadu_si256((const __m256i*)(data + i * Size));
+				__m256i b = _mm256_loadu_si256((const __m256i*)(data + (i + perVec) * Size));
+				_mm256_storeu_si256((__m256i*)(data + i * Size), _mm256_shuffle_epi8(a, mask));
+				_mm256_storeu_si256((__m256i*)(data + (i + perVec) * Size), _mm256_shuffle_epi8(b, mask));
+			}
+			for (; i + perVec <= count; i += perVec)
+			{
+				__m256i a = _mm256_loadu_si256((const __m256i*)(data + i * Size));
+				_mm256_storeu_si256((__m256i*)(data + i * Size), _mm256_shuffle_epi8(a, mask));
+			}
+			return i;
+		}
+#endif
+
+		// Reverses the bytes of every element in place
+		template <typename T>
+		inline void
+		byteSwapArray(T* dst, size_t count)
+		{
+			constexpr size_t Size = sizeof(T);
+			uint8_t* data = (uint8_t*)dst;
+
+			if constexpr (Size == 1)
+				return;
+			else
+			{
+				size_t done = 0;
+#ifdef BINARYREADER_X86_SIMD
+				if constexpr (Size == 2 || Size == 4 || Size == 8)
+				{
+					if (hasAVX2())
+						done = _byteSwapAVX2<Size>(data, count);
+					else if (hasSSSE3())
+						done = _byteSwapSSSE3<Size>(data, count);
+				}
+#endif
+				_byteSwapScalar<Size>(data + done * Size, count - done);
+			}
+		}
+
+		// Reverses the bytes of one value. Compiles to a single bswap (a rotate for 16 bits)
+		template <typename T>
+		requires std::is_trivially_copyable_v<T>
+		inline T
+		byteSwap(T value)
+		{
+			if constexpr (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)
+			{
+				using Bits = std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+				Bits bits;
+				std::memcpy(&bits, &value, sizeof(T));
+				if constexpr (sizeof(T) == 2)
+					bits = bswap16(bits);
+				else if constexpr (sizeof(T) == 4)
+					bits = bswap32(bits);
+				else
+					bits = bswap64(bits);
+				std::memcpy(&value, &bits, sizeof(T));
+			}
+			else
+				_byteSwapScalar<sizeof(T)>((uint8_t*)&value, 1);
+			return value;
+		}
+
+		// Values stored in `Order` to host order and back. Nothing at all when the two match
+		template <std::endian Order, typename T>
+		inline T
+		toNative(T value)
+		{
+			if constexpr (Order != std::endian::native && sizeof(T) > 1)
+				return byteSwap(value);
+			else
+				return value;
+		}
+
+		template <std::endian Order, typename T>
+		inline void
+		toNativeArray(T* data, size_t count)
+		{
+			if constexpr (Order != std::endian::native && sizeof(T) > 1)
+				byteSwapArray(data, count);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Record permutation
+		//
+		// Rearranges the bytes of `count` back-to-back records of `stride` bytes in place
+		// Byte j of each record is replaced by byte perm[j] of the same record
+		// The record pattern repeats every lcm(stride, 16) bytes, so each 16-byte chunk of that period
+		//   gets its own pshufb control. Chunks never overlap, so there are no store-to-load stalls
+
+#ifdef BINARYREADER_X86_SIMD
+		constexpr size_t MAX_PERMUTE_CHUNKS = 16;
+
+		// Fills one control per 16-byte chunk of the period. Returns the chunk count,
+		//   or 0 if a byte would have to move across chunks (possible with packed structs)
+		inline size_t
+		_permuteControls(size_t stride, const uint8_t* perm, uint8_t (*control)[16])
+		{
+			size_t period = stride;
+			while (period % 16 != 0)
+				period += stride;
+			size_t chunks = period / 16;
+			if (chunks > MAX_PERMUTE_CHUNKS)
+				return 0;
+
+			for (size_t c = 0; c < chunks; c++)
+			{
+				for (size_t j = 0; j < 16; j++)
+				{
+					size_t at = c * 16 + j;
+					size_t src = at - at % stride + perm[at % stride];
+					if (src / 16 != c)
+						return 0;
+					control[c][j] = (uint8_t)(src - c * 16);
+				}
+			}
+			return chunks;
+		}
+
+		[[gnu::target("avx2")]] inline size_t
+		_permuteRecordsAVX2(uint8_t* data, size_t count, size_t stride, const uint8_t (*control)[16], size_t chunks)
+		{
+			// vpshufb works per 128-bit lane, so 2 chunks go in each register
+			// An odd chunk count is doubled so whole periods still land on register boundaries
+			__m256i masks[MAX_PERMUTE_CHUNKS];
+			size_t pairs = chunks % 2 == 0 ? chunks / 2 : chunks;
+			for (size_t p = 0; p < pairs; p++)
+			{
+				__m128i lo = _mm_load_si128((const __m128i*)control[(p * 2) % chunks]);
+				__m128i hi = _mm_load_si128((const __m128i*)control[(p * 2 + 1) % chunks]);
+				masks[p] = _mm256_set_m128i(hi, lo);
+			}
+
+			size_t period = pairs * 32;
+			size_t bytes = count * stride;
+			size_t pos = 0;
+			for (; pos + period <= bytes; pos += period)
+			{
+				for (size_t p = 0; p < pairs; p++)
+				{
+					__m256i v = _mm256_loadu_si256((const __m256i*)(data + pos + p * 32));
+					_mm256_storeu_si256((__m256i*)(data + pos + p * 32), _mm256_shuffle_epi8(v, masks[p]));
+				}
+			}
+			return pos / stride;
+		}
+
+		[[gnu::target("ssse3")]] inline size_t
+		_permuteRecordsSSSE3(uint8_t* data, size_t count, size_t stride, const uint8_t (*control)[16], size_t chunks)
+		{
+			__m128i masks[MAX_PERMUTE_CHUNKS];
+			for (size_t c = 0; c < chunks; c++)
+				masks[c] = _mm_load_si128((const __m128i*)control[c]);
+
+			size_t period = chunks * 16;
+			size_t bytes = count * stride;
+			size_t pos = 0;
+			for (; pos + period <= bytes; pos += period)
+			{
+				for (size_t c = 0; c < chunks; c++)
+				{
+					__m128i v = _mm_loadu_si128((const __m128i*)(data + pos + c * 16));
+					_mm_storeu_si128((__m128i*)(data + pos + c * 16), _mm_shuffle_epi8(v, masks[c]));
+				}
+			}
+			return pos / stride;
+		}
+#endif
+
+		// Returns how many leading records were permuted; the caller handles the rest
+		inline size_t
+		permuteRecords(uint8_t* data, size_t count, size_t stride, const uint8_t* perm)
+		{
+#ifdef BINARYREADER_X86_SIMD
+			if (!hasSSSE3())
+				return 0;
+
+			alignas(16) uint8_t control[MAX_PERMUTE_CHUNKS][16];
+			size_t chunks = _permuteControls(stride, perm, control);
+			if (chunks == 0)
+				return 0;
+			if (hasAVX2())
+				return _permuteRecordsAVX2(data, count, stride, control, chunks);
+			return _permuteRecordsSSSE3(data, count, stride, control, chunks);
+#else
+			return 0;
+#endif
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Strided gather
+		//
+		// Copies `width` bytes from the start of each of `count` records, `stride` bytes apart, into contiguous `dst`
+
+		template <size_t Width>
+		inline void
+		_gatherFixed(uint8_t* dst, const uint8_t* src, size_t stride, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+				std::memcpy(dst + i * Width, src + i * stride, Width);
+		}
+
+		inline void
+		_gatherScalar(uint8_t* dst, const uint8_t* src, size_t stride, size_t width, size_t count)
+		{
+			// Fixed widths become plain register moves
+			switch (width)
+			{
+			case 1: return _gatherFixed<1>(dst, src, stride, count);
+			case 2: return _gatherFixed<2>(dst, src, stride, count);
+			case 3: return _gatherFixed<3>(dst, src, stride, count);
+			case 4: return _gatherFixed<4>(dst, src, stride, count);
+			case 6: return _gatherFixed<6>(dst, src, stride, count);
+			case 8: return _gatherFixed<8>(dst, src, stride, count);
+			case 12: return _gatherFixed<12>(dst, src, stride, count);
+			case 16: return _gatherFixed<16>(dst, src, stride, count);
+			default:
+				for (size_t i = 0; i < count; i++)
+					std::memcpy(dst + i * width, src + i * stride, width);
+			}
+		}
+
+#ifdef BINARYREADER_X86_SIMD
+		// Widths of 4, 8, 12 or 16 bytes, as 32-bit words: 8 records take `words` gathers of 8 words each
+		// Returns the number of records copied
+		[[gnu::target("avx2")]] inline size_t
+		_gatherAVX2(uint8_t* dst, const uint8_t* src, size_t stride, size_t width, size_t count)
+		{
+			const size_t words = width / 4;
+			__m256i index[4];
+			for (size_t g = 0; g < words; g++)
+			{
+				alignas(32) int32_t offsets[8];
+				for (size_t j = 0; j < 8; j++)
+				{
+					size_t word = g * 8 + j;
+					offsets[j] = (int32_t)(word / words * stride + word % words * 4);
+				}
+				index[g] = _mm256_load_si256((const __m256i*)offsets);
+			}
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const int* base = (const int*)(src + i * stride);
+				uint8_t* out = dst + i * width;
+				for (size_t g = 0; g < words; g++)
+					_mm256_storeu_si256((__m256i*)(out + g * 32), _mm256_i32gather_epi32(base, index[g], 1));
+			}
+			return i;
+		}
+#endif
+
+		inline void
+		gatherStrided(uint8_t* dst, const uint8_t* src, size_t stride, size_t width, size_t count)
+		{
+			if (stride == width)
+			{
+				std::memcpy(dst, src, width * count);
+				return;
+			}
+
+			size_t done = 0;
+#ifdef BINARYREADER_X86_SIMD
+			// Gathers beat scalar copies while several records share a cache line
+			if (width % 4 == 0 && width <= 16 && stride <= 32 && hasAVX2())
+				done = _gatherAVX2(dst, src, stride, width, count);
+#endif
+			_gatherScalar(dst + done * width, src + done * stride, stride, width, count - done);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Half-floats
+		//
+		// All paths are bit-exact with BasicReader::_readHalfFloat, including NaN payloads
+		// `src` may alias the upper half of `dst` (see BasicReader::readHalfArray)
+		// Elements are converted in ascending order, and each block is loaded before it is stored
+
+		// Rebias the exponent by integer add, then renormalize subnormals with one float subtract
+		inline float
+		halfToFloat(uint16_t h)
+		{
+			const uint32_t magic = 113u << 23;   // 2^-14
+			uint32_t bits = (uint32_t)(h & 0x7fff) << 13;
+			uint32_t exp = bits & 0x0f800000;
+			bits += (127u - 15u) << 23;
+			if (exp == 0x0f800000)              // NaN/Inf
+				bits += (128u - 16u) << 23;
+			else if (exp == 0)                   // Zero/subnormal
+			{
+				bits += 1u << 23;
+				float f, m;
+				std::memcpy(&f, &bits, 4);
+				std::memcpy(&m, &magic, 4);
+				f -= m;
+				std::memcpy(&bits, &f, 4);
+			}
+			bits |= (uint32_t)(h & 0x8000) << 16;
+
+			float ret;
+			std::memcpy(&ret, &bits, 4);
+			return ret;
+		}
+
+#ifdef BINARYREADER_X86_SIMD
+		[[gnu::target("sse2")]] inline __m128i
+		_halfToFloatBitsSSE2(__m128i h)
+		{
+			const __m128i expMask = _mm_set1_epi32(0x0f800000);
+			const __m128i magic = _mm_set1_epi32(113 << 23);
+			__m128i bits = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+			__m128i exp = _mm_and_si128(bits, expMask);
+			bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+
+			__m128i isInfNan = _mm_cmpeq_epi32(exp, expMask);
+			bits = _mm_add_epi32(bits, _mm_and_si128(isInfNan, _mm_set1_epi32((128 - 16) << 23)));
+
+			__m128i isSmall = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+			__m128i renorm = _mm_castps_si128(_mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(magic)));
+			bits = _mm_or_si128(_mm_and_si128(isSmall, renorm), _mm_andnot_si128(isSmall, bits));
+
+			__m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+			return _mm_or_si128(bits, sign);
+		}
+
+		[[gnu::target("sse2")]] inline size_t
+		_halfToFloatSSE2(const uint16_t* src, float* dst, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(src + i)), _mm_setzero_si128());
+				_mm_storeu_si128((__m128i*)(dst + i), _halfToFloatBitsSSE2(h));
+			}
+			return i;
+		}
+
+		[[gnu::target("avx2")]] inline __m256i
+		_halfToFloatBitsAVX2(__m256i h)
+		{
+			const __m256i expMask = _mm256_set1_epi32(0x0f800000);
+			const __m256i magic = _mm256_set1_epi32(113 << 23);
+			__m256i bits = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x7fff)), 13);
+			__m256i exp = _mm256_and_si256(bits, expMask);
+			bits = _mm256_add_epi32(bits, _mm256_set1_epi32((127 - 15) << 23));
+
+			__m256i isInfNan = _mm256_cmpeq_epi32(exp, expMask);
+			bits = _mm256_add_epi32(bits, _mm256_and_si256(isInfNan, _mm256_set1_epi32((128 - 16) << 23)));
+
+			__m256i isSmall = _mm256_cmpeq_epi32(exp, _mm256_setzero_si256());
+			__m256i renorm = _mm256_castps_si256(_mm256_sub_ps(_mm256_castsi256_ps(_mm256_add_epi32(bits, _mm256_set1_epi32(1 << 23))), _mm256_castsi256_ps(magic)));
+			bits = _mm256_blendv_epi8(bits, renorm, isSmall);
+
+			__m256i sign = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x8000)), 16);
+			return _mm256_or_si256(bits, sign);
+		}
+
+		[[gnu::target("avx2")]] inline size_t
+		_halfToFloatAVX2(const uint16_t* src, float* dst, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+				_mm256_storeu_si256((__m256i*)(dst + i), _halfToFloatBitsAVX2(h));
+			}
+			return i;
+		}
+
+		// vcvtph2ps quiets signaling NaNs, so blocks containing NaN/Inf take the integer path
+		[[gnu::target("avx2,f16c")]] inline size_t
+		_halfToFloatF16C(const uint16_t* src, float* dst, size_t count)
+		{
+			const __m128i expMask = _mm_set1_epi16(0x7c00);
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				__m128i h = _mm_loadu_si128((const __m128i*)(src + i));
+				__m128i special = _mm_cmpeq_epi16(_mm_and_si128(h, expMask), expMask);
+				if (_mm_movemask_epi8(special) == 0)
+					_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+				else
+					_mm256_storeu_si256((__m256i*)(dst + i), _halfToFloatBitsAVX2(_mm256_cvtepu16_epi32(h)));
+			}
+			return i;
+		}
+#endif
+
+		inline void
+		halfToFloatArray(const uint16_t* src, float* dst, size_t count)
+		{
+			size_t done = 0;
+#ifdef BINARYREADER_X86_SIMD
+			if (hasF16C() && hasAVX2())
+				done = _halfToFloatF16C(src, dst, count);
+			else if (hasAVX2())
+				done = _halfToFloatAVX2(src, dst, count);
+			else if (hasSSE2())
+				done = _halfToFloatSSE2(src, dst, count);
+#endif
+			for (size_t i = done; i < count; i++)
+			{
+				uint16_t h;
+				std::memcpy(&h, src + i, sizeof(uint16_t));
+				dst[i] = halfToFloat(h);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Integer range checks
+		//
+		// Return the index of the first failing element, or `count` if all pass
+
+#ifdef BINARYREADER_X86_SIMD
+		template <size_t Size>
+		[[gnu::target("avx2")]] inline __m256i
+		_broadcast(uint64_t v)
+		{
+			if constexpr (Size == 1)
+				return _mm256_set1_epi8((char)v);
+			else if constexpr (Size == 2)
+				return _mm256_set1_epi16((short)v);
+			else if constexpr (Size == 4)
+				return _mm256_set1_epi32((int)v);
+			else
+				return _mm256_set1_epi64x((long long)v);
+		}
+
+		template <size_t Size>
+		[[gnu::target("avx2")]] inline __m256i
+		_cmpgt(__m256i a, __m256i b)
+		{
+			if constexpr (Size == 1)
+				return _mm256_cmpgt_epi8(a, b);
+			else if constexpr (Size == 2)
+				return _mm256_cmpgt_epi16(a, b);
+			else if constexpr (Size == 4)
+				return _mm256_cmpgt_epi32(a, b);
+			else
+				return _mm256_cmpgt_epi64(a, b);
+		}
+
+		template <size_t Size>
+		[[gnu::target("avx2")]] inline __m256i
+		_cmpeq(__m256i a, __m256i b)
+		{
+			if constexpr (Size == 1)
+				return _mm256_cmpeq_epi8(a, b);
+			else if constexpr (Size == 2)
+				return _mm256_cmpeq_epi16(a, b);
+			else if constexpr (Size == 4)
+				return _mm256_cmpeq_epi32(a, b);
+			else
+				return _mm256_cmpeq_epi64(a, b);
+		}
+
+		// Returns how many leading elements are known to pass
+		// Stops at the first 4-vector block containing a failure
+		template <typename T>
+		[[gnu::target("avx2")]] inline size_t
+		_findOutOfRangeAVX2(const T* data, size_t count, T min, T max)
+		{
+			constexpr size_t Size = sizeof(T);
+			constexpr size_t perVec = 32 / Size;
+			// AVX2 only compares signed lanes; flipping the sign bit maps unsigned order onto signed order
+			const __m256i bias = std::is_signed_v<T> ? _mm256_setzero_si256() : _broadcast<Size>(1ull << (Size * 8 - 1));
+			const __m256i vMin = _mm256_xor_si256(_broadcast<Size>((uint64_t)min), bias);
+			const __m256i vMax = _mm256_xor_si256(_broadcast<Size>((uint64_t)max), bias);
+
+			size_t i = 0;
+			for (; i + perVec * 4 <= count; i += perVec * 4)
+			{
+				__m256i bad = _mm256_setzero_si256();
+				for (size_t j = 0; j < 4; j++)
+				{
+					__m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i + j * perVec)), bias);
+					// Fails if (min > v) or !(max > v)
+					bad = _mm256_or_si256(bad, _cmpgt<Size>(vMin, v));
+					bad = _mm256_or_si256(bad, _mm256_andnot_si256(_cmpgt<Size>(vMax, v), _mm256_set1_epi8(-1)));
+				}
+				if (!_mm256_testz_si256(bad, bad))
+					break;
+			}
+			return i;
+		}
+
+		template <typename T>
+		[[gnu::target("avx2")]] inline size_t
+		_findNotEqualAVX2(const T* data, size_t count, T exact)
+		{
+			constexpr size_t Size = sizeof(T);
+			constexpr size_t perVec = 32 / Size;
+			const __m256i vExact = _broadcast<Size>((uint64_t)exact);
+
+			size_t i = 0;
+			for (; i + perVec * 4 <= count; i += perVec * 4)
+			{
+				__m256i good = _mm256_set1_epi8(-1);
+				for (size_t j = 0; j < 4; j++)
+				{
+					__m256i v = _mm256_loadu_si256((const __m256i*)(data + i + j * perVec));
+					good = _mm256_and_si256(good, _cmpeq<Size>(v, vExact));
+				}
+				if (_mm256_movemask_epi8(good) != -1)
+					break;
+			}
+			return i;
+		}
+#endif
+
+		template <typename T>
+		requires std::is_integral_v<T>
+		inline size_t
+		findOutOfRange(const T* data, size_t count, T min, T max)
+		{
+			size_t i = 0;
+#ifdef BINARYREADER_X86_SIMD
+			if constexpr (sizeof(T) <= 8)
+			{
+				if (hasAVX2())
+					i = _findOutOfRangeAVX2(data, count, min, max);
+			}
+#endif
+			for (; i < count; i++)
+			{
+				if (data[i] < min || data[i] >= max)
+					break;
+			}
+			return i;
+		}
+
+		template <typename T>
+		requires std::is_integral_v<T>
+		inline size_t
+		findNotEqual(const T* data, size_t count, T exact)
+		{
+			size_t i = 0;
+#ifdef BINARYREADER_X86_SIMD
+			if constexpr (sizeof(T) <= 8)
+			{
+				if (hasAVX2())
+					i = _findNotEqualAVX2(data, count, exact);
+			}
+#endif
+			for (; i < count; i++)
+			{
+				if (data[i] != exact)
+					break;
+			}
+			return i;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////
+		// Float checks
+
+		template <typename T>
+		using FloatKey = std::conditional_t<sizeof(T) == 4, int32_t, int64_t>;
+
+		// Signed integer that orders like the float, one step per ULP (-0 sits one step below +0)
+		template <typename T>
+		requires std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8)
+		inline FloatKey<T>
+		floatKey(T value)
+		{
+			using Key = FloatKey<T>;
+			Key bits;
+			std::memcpy(&bits, &value, sizeof(T));
+			// Negative floats are sign-magnitude; flipping the magnitude makes them two's complement ordered
+			return bits ^ ((bits >> (sizeof(T) * 8 - 1)) & std::numeric_limits<Key>::max());
+		}
+
+#ifdef BINARYREADER_X86_SIMD
+		// Returns how many leading elements passed; they have been fixed up in place
+		// Stops at the first vector containing a failure
+		template <typename T>
+		[[gnu::target("avx2")]] inline size_t
+		_fixFloatsAVX2(T* data, size_t count, FloatKey<T> keyMin, FloatKey<T> keyMax, bool convertInf, bool convertZero, bool failSubnormal)
+		{
+			constexpr size_t Size = sizeof(T);
+			constexpr size_t perVec = 32 / Size;
+			constexpr uint64_t SIGN = 1ull << (Size * 8 - 1);
+			constexpr uint64_t EXPONENT = Size == 4 ? 0x7F800000ull : 0x7FF0000000000000ull;
+			constexpr uint64_t MIN_NORMAL = Size == 4 ? 0x00800000ull : 0x0010000000000000ull;
+			constexpr uint64_t MAX_FINITE = Size == 4 ? 0x7F7FFFFFull : 0x7FEFFFFFFFFFFFFFull;
+
+			const __m256i vSign = _broadcast<Size>(SIGN);
+			const __m256i vMagnitude = _broadcast<Size>(SIGN - 1);
+			const __m256i vExponent = _broadcast<Size>(EXPONENT);
+			const __m256i vMinNormal = _broadcast<Size>(MIN_NORMAL);
+			const __m256i vMaxFinite = _broadcast<Size>(MAX_FINITE);
+			const __m256i vKeyMin = _broadcast<Size>((uint64_t)keyMin);
+			const __m256i vKeyMax = _broadcast<Size>((uint64_t)keyMax);
+			const __m256i zero = _mm256_setzero_si256();
+			const __m256i ones = _mm256_set1_epi8(-1);
+			const __m256i infAllowed = convertInf ? ones : zero;
+			const __m256i subnormalFails = failSubnormal ? ones : zero;
+
+			size_t i = 0;
+			for (; i + perVec <= count; i += perVec)
+			{
+				__m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+				__m256i abs = _mm256_and_si256(v, vMagnitude);
+
+				__m256i isInf = _cmpeq<Size>(abs, vExponent);
+				__m256i isNaN = _cmpgt<Size>(abs, vExponent);
+				__m256i isZero = _cmpeq<Size>(abs, zero);
+				__m256i isSubnormal = _mm256_andnot_si256(isZero, _cmpgt<Size>(vMinNormal, abs));
+				__m256i bad = _mm256_or_si256(isNaN, _mm256_andnot_si256(infAllowed, isInf));
+				bad = _mm256_or_si256(bad, _mm256_and_si256(subnormalFails, isSubnormal));
+
+				// CONV_INF: +-inf -> +-max. CONV_ZERO: -0 -> +0
+				__m256i fixed = _mm256_blendv_epi8(v, _mm256_or_si256(_mm256_and_si256(v, vSign), vMaxFinite), isInf);
+				if (convertZero)
+					fixed = _mm256_andnot_si256(isZero, fixed);
+
+				// Same key as floatKey: flip the magnitude of negative lanes
+				__m256i negative = _cmpgt<Size>(zero, fixed);
+				__m256i key = _mm256_xor_si256(fixed, _mm256_and_si256(negative, vMagnitude));
+				bad = _mm256_or_si256(bad, _cmpgt<Size>(vKeyMin, key));
+				bad = _mm256_or_si256(bad, _mm256_andnot_si256(_cmpgt<Size>(vKeyMax, key), ones));
+
+				if (!_mm256_testz_si256(bad, bad))
+					break;
+				_mm256_storeu_si256((__m256i*)(data + i), fixed);
+			}
+			return i;
+		}
+#endif
+
+		// One element of fixFloats. A failing element is left as it was
+		template <typename T>
+		inline bool
+		_fixFloat(T& value, FloatKey<T> keyMin, FloatKey<T> keyMax, bool convertInf, bool convertZero, bool failSubnormal)
+		{
+			T fixed = value;
+			switch (std::fpclassify(value))
+			{
+			case FP_NAN:
+				return false;
+			case FP_INFINITE:
+				if (!convertInf)
+					return false;
+				fixed = value > 0 ? std::numeric_limits<T>::max() : -std::numeric_limits<T>::max();
+				break;
+			case FP_ZERO:
+				if (convertZero)
+					fixed = 0;
+				break;
+			case FP_SUBNORMAL:
+				if (failSubnormal)
+					return false;
+				break;
+			default:
+				break;
+			}
+
+			FloatKey<T> key = floatKey(fixed);
+			if (key < keyMin || key >= keyMax)
+				return false;
+			value = fixed;
+			return true;
+		}
+
+		// The Safe float checks: classifies each element, applies the conversions, and checks that its key lies in [keyMin, keyMax)
+		// Whole vectors are done with blends; the tail and the vector holding the first failure one element at a time
+		// Returns the index of the first failing element, or `count`. Every element before it has been fixed up in place
+		template <typename T>
+		requires std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8)
+		inline size_t
+		fixFloats(T* data, size_t count, FloatKey<T> keyMin, FloatKey<T> keyMax, bool convertInf, bool convertZero, bool failSubnormal)
+		{
+			size_t i = 0;
+#ifdef BINARYREADER_X86_SIMD
+			if (hasAVX2())
+				i = _fixFloatsAVX2(data, count, keyMin, keyMax, convertInf, convertZero, failSubnormal);
+#endif
+			for (; i < count; i++)
+			{
+				if (!_fixFloat(data[i], keyMin, keyMax, convertInf, convertZero, failSubnormal))
+					break;
+			}
+			return i;
+		}
+	};
+};
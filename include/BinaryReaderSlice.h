@@ -5,6 +5,7 @@
 
 #include <fstream>
 #include <string>
+#include <stdexcept>
 #include <cstring>
 #include <vector>
 
@@ -19,17 +20,26 @@ namespace BinaryReader
 		void
 		readBytes(void* dst, int count) override
 		{
+			_check(count);
 			std::memcpy(dst, m_dataPtr + m_curPos, count);
 			m_curPos += count;
 		}
 		
+		const uint8_t*
+		cursorPtr(size_t& remaining) override
+		{
+			remaining = m_curPos < m_size ? m_size - m_curPos : 0;
+			return m_dataPtr + m_curPos;
+		}
+
 		void
-		readBytesBE(void* dst, int count) override
+		_check(size_t count) const
 		{
-			for (size_t i = 0; i < count; i++)
-				std::memcpy((char*)dst + i, &m_dataPtr[m_curPos + count - i], 1);
-			
-			m_curPos += count;
+			if constexpr (DEFAULT_BOUNDS == Bounds::Checked)
+			{
+				if (m_curPos > m_size || count > m_size - m_curPos)
+					throw std::out_of_range("Read past end of data");
+			}
 		}
 
 	public:
@@ -62,6 +72,7 @@ namespace BinaryReader
 		BinaryReaderSlice&
 		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur) override
 		{
+			_statSeek(offset, way);
 			switch (way)
 			{
 			case std::ios_base::beg:
@@ -83,6 +94,14 @@ namespace BinaryReader
 			return m_curPos;
 		}
 
+		void
+		readBytesAt(void* dst, size_t count, size_t offset) const override
+		{
+			if (offset > m_size || count > m_size - offset)
+				throw std::out_of_range("Positional read out of bounds");
+			std::memcpy(dst, m_dataPtr + offset, count);
+		}
+
 		BinaryReaderSlice
 		slice(size_t size)
 		{
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "BinaryReaderBasic.h"
+#include "BinaryReaderExceptions.h"
+
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <stdexcept>
+
+namespace BinaryReader
+{
+	// Non-virtual view over memory
+	// Same interface as BinaryReaderSlice, but every read inlines down to a plain load (plus a compare when checked)
+	template <Bounds Policy>
+	class BasicStaticSlice final : public BasicReader<BasicStaticSlice<Policy>>
+	{
+		friend class BasicReader<BasicStaticSlice<Policy>>;
+
+		size_t m_size;
+		const uint8_t* m_dataPtr;
+		size_t m_curPos;
+
+		void
+		readBytes(void* dst, size_t count)
+		{
+			_check(count);
+			std::memcpy(dst, m_dataPtr + m_curPos, count);
+			m_curPos += count;
+		}
+
+		const uint8_t*
+		cursorPtr(size_t& remaining) const
+		{
+			remaining = m_curPos < m_size ? m_size - m_curPos : 0;
+			return m_dataPtr + m_curPos;
+		}
+
+		void
+		_check(size_t count) const
+		{
+			if constexpr (Policy == Bounds::Checked)
+			{
+				if (m_curPos > m_size || count > m_size - m_curPos)
+					throw std::out_of_range("Read past end of data");
+			}
+		}
+
+	public:
+		BasicStaticSlice()
+			: m_size(0), m_dataPtr(nullptr), m_curPos(0)
+		{
+		}
+
+		BasicStaticSlice(const uint8_t* data, size_t size)
+			: m_size(size), m_dataPtr(data), m_curPos(0)
+		{
+		}
+
+		size_t
+		getLength() const
+		{
+			return m_size;
+		}
+
+		const uint8_t*
+		getPtr() const
+		{
+			return m_dataPtr;
+		}
+
+		BasicStaticSlice&
+		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur)
+		{
+			this->_statSeek(offset, way);
+			switch (way)
+			{
+			case std::ios_base::beg:
+				m_curPos = offset;
+				break;
+			case std::ios_base::cur:
+				m_curPos += offset;
+				break;
+			case std::ios_base::end:
+				m_curPos = m_size + offset;
+				break;
+			}
+			return *this;
+		}
+
+		size_t
+		tell() const
+		{
+			return m_curPos;
+		}
+
+		void
+		readBytesAt(void* dst, size_t count, size_t offset) const
+		{
+			if (offset > m_size || count > m_size - offset)
+				throw std::out_of_range("Positional read out of bounds");
+			std::memcpy(dst, m_dataPtr + offset, count);
+		}
+
+		BasicStaticSlice
+		slice(size_t size)
+		{
+			BasicStaticSlice ret(m_dataPtr + tell(), size);
+			seek(size, std::ios::cur);
+			return ret;
+		}
+	};
+
+	using BinaryReaderStaticSlice = BasicStaticSlice<DEFAULT_BOUNDS>;
+	// What BasicReader::record hands out: no per-read checks, whatever BINARYREADER_BOUNDS_CHECK says
+	using RecordSlice = BasicStaticSlice<Bounds::Unchecked>;
+
+	template <class Derived>
+	RecordSlice
+	BasicReader<Derived>::record(size_t count)
+	{
+		const uint8_t* src = _view(count);
+		return RecordSlice(src, count);
+	}
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// Define BINARYREADER_STATS (identically in every translation unit) to count I/O per reader
+// Without it the counters and every hook compile away, and stats() returns zeros
+#ifdef BINARYREADER_STATS
+	#define BINARYREADER_STATS_ENABLED true
+#else
+	#define BINARYREADER_STATS_ENABLED false
+#endif
+
+namespace BinaryReader
+{
+	// Snapshot of what a reader has done since construction or the last resetStats()
+	// Positional reads (readAt, readBytesAt) are stateless and not counted
+	struct ReaderStats
+	{
+		static constexpr bool ENABLED = BINARYREADER_STATS_ENABLED;
+		// Bucket i holds values in [2^(i-1), 2^i); bucket 0 holds 0
+		static constexpr size_t HISTOGRAM_BUCKETS = 65;
+
+		// Calls into the backend's readBytes, and the bytes they returned
+		uint64_t readCalls = 0;
+		uint64_t bytesRead = 0;
+		// The subset of readCalls that read big-endian data
+		uint64_t readBECalls = 0;
+		// Bytes consumed straight from cursorData by bulk decoders, without a readBytes call
+		uint64_t bytesDecodedInPlace = 0;
+		// Seeks that moved the cursor. Rewinds done internally by Safe reads are not included
+		uint64_t seeks = 0;
+		uint64_t backwardSeeks = 0;
+		// LimitException and NonNormalFloatException thrown by Safe reads
+		uint64_t safeFailures = 0;
+
+		std::array<uint64_t, HISTOGRAM_BUCKETS> readSizes = {};
+		std::array<uint64_t, HISTOGRAM_BUCKETS> seekDistances = {};
+
+		static size_t
+		bucket(uint64_t value)
+		{
+			return (size_t)std::bit_width(value);
+		}
+
+		// Smallest value that lands in `index`
+		static uint64_t
+		bucketFloor(size_t index)
+		{
+			return index == 0 ? 0 : 1ull << (index - 1);
+		}
+
+		double
+		averageReadSize() const
+		{
+			return readCalls == 0 ? 0.0 : (double)bytesRead / readCalls;
+		}
+
+		void
+		recordRead(size_t size, bool bigEndian)
+		{
+			readCalls++;
+			bytesRead += size;
+			readBECalls += bigEndian;
+			readSizes[bucket(size)]++;
+		}
+
+		void
+		recordSeek(size_t from, size_t to)
+		{
+			if (from == to)
+				return;
+			seeks++;
+			backwardSeeks += to < from;
+			seekDistances[bucket(to < from ? from - to : to - from)]++;
+		}
+	};
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace BinaryReader
+{
+	// Interning arena for names that repeat a lot (paths, type names)
+	// Each distinct string is copied once into a large block; later copies get the same view back
+	// Views stay valid, and null-terminated, until the pool is cleared or destroyed. Not thread-safe
+	class StringPool
+	{
+		std::vector<std::unique_ptr<char[]>> m_blocks;
+		size_t m_blockSize;
+		char* m_cur;
+		size_t m_left;
+		size_t m_bytes;
+		std::unordered_set<std::string_view> m_strings;
+
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+		explicit StringPool(size_t blockSize = DEFAULT_BLOCK_SIZE)
+			: m_blocks(), m_blockSize(std::max<size_t>(blockSize, 1)), m_cur(nullptr), m_left(0), m_bytes(0), m_strings()
+		{
+		}
+
+		StringPool(const StringPool&) = delete;
+		StringPool& operator=(const StringPool&) = delete;
+		StringPool(StringPool&&) = default;
+		StringPool& operator=(StringPool&&) = default;
+
+		std::string_view
+		intern(std::string_view str)
+		{
+			auto it = m_strings.find(str);
+			if (it != m_strings.end())
+				return *it;
+
+			char* dst = _allocate(str.size() + 1);
+			std::memcpy(dst, str.data(), str.size());
+			dst[str.size()] = '\0';
+
+			std::string_view ret(dst, str.size());
+			m_strings.insert(ret);
+			m_bytes += str.size() + 1;
+			return ret;
+		}
+
+		// The interned copy of `str`, or an empty view if it was never interned
+		std::string_view
+		find(std::string_view str) const
+		{
+			auto it = m_strings.find(str);
+			return it != m_strings.end() ? *it : std::string_view();
+		}
+
+		bool
+		contains(std::string_view str) const
+		{
+			return m_strings.contains(str);
+		}
+
+		// Distinct strings held
+		size_t
+		size() const
+		{
+			return m_strings.size();
+		}
+
+		// Bytes taken up by the strings, including terminators
+		size_t
+		bytesUsed() const
+		{
+			return m_bytes;
+		}
+
+		void
+		clear()
+		{
+			m_strings.clear();
+			m_blocks.clear();
+			m_cur = nullptr;
+			m_left = 0;
+			m_bytes = 0;
+		}
+
+	private:
+		char*
+		_allocate(size_t count)
+		{
+			// Strings bigger than a block get one of their own, so the current block isn't wasted
+			if (count > m_blockSize)
+			{
+				m_blocks.push_back(std::make_unique_for_overwrite<char[]>(count));
+				return m_blocks.back().get();
+			}
+
+			if (count > m_left)
+			{
+				m_blocks.push_back(std::make_unique_for_overwrite<char[]>(m_blockSize));
+				m_cur = m_blocks.back().get();
+				m_left = m_blockSize;
+			}
+
+			char* ret = m_cur;
+			m_cur += count;
+			m_left -= count;
+			return ret;
+		}
+	};
+};
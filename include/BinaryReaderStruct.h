@@ -0,0 +1,102 @@
+#pragma once
+
+#include "BinaryReaderSimd.h"
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace BinaryReader
+{
+	template <typename T>
+	concept isStructField = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+	// One member of a struct read by BasicReader::readStruct, and the byte order it is stored in
+	// Members that are stored in native order don't need to be listed
+	template <auto Member, std::endian Order = std::endian::little>
+	struct Field;
+
+	template <class S, isStructField M, M S::*Member, std::endian Order>
+	struct Field<Member, Order>
+	{
+		using Struct = S;
+		using Type = M;
+		static constexpr bool SWAPPED = Order != std::endian::native && sizeof(M) > 1;
+
+		static void
+		fix(S& item)
+		{
+			if constexpr (SWAPPED)
+			{
+				uint8_t bytes[sizeof(M)];
+				std::memcpy(bytes, &(item.*Member), sizeof(M));
+				Simd::_byteSwapScalar<sizeof(M)>(bytes, 1);
+				std::memcpy(&(item.*Member), bytes, sizeof(M));
+			}
+		}
+
+		// Reverses this member's bytes in a byte permutation of the whole struct
+		// The offset is measured on a real object, so S must be default constructible
+		static void
+		addToPermutation(uint8_t* perm)
+		{
+			if constexpr (SWAPPED)
+			{
+				static const S probe{};
+				size_t offset = (size_t)((const uint8_t*)&(probe.*Member) - (const uint8_t*)&probe);
+				for (size_t i = 0; i < sizeof(M); i++)
+					perm[offset + i] = (uint8_t)(offset + sizeof(M) - 1 - i);
+			}
+		}
+	};
+
+	// Wire layout of a trivially copyable struct: its in-memory layout, with some members byte-swapped
+	// struct Header { uint32_t magic; uint16_t version; uint64_t size; };
+	// using HeaderLayout = StructLayout<Header, Field<&Header::magic, std::endian::big>, Field<&Header::size, std::endian::big>>;
+	// reader.readStruct<HeaderLayout>();
+	template <class S, class... Fields>
+	requires std::is_trivially_copyable_v<S> && (std::same_as<typename Fields::Struct, S> && ...)
+	struct StructLayout
+	{
+		using Type = S;
+		static constexpr bool NEEDS_FIXUP = (Fields::SWAPPED || ...);
+		// Structs that can't be default constructed have no probe object to measure offsets on, see Field::addToPermutation
+		static constexpr bool SIMD_FIXUP = std::is_default_constructible_v<S> && sizeof(S) <= 256;
+
+		// Swaps the listed members of each item in place
+		static void
+		fixup(S* items, size_t count)
+		{
+			if constexpr (NEEDS_FIXUP)
+			{
+				// Whole records are shuffled with SIMD, the tail member by member
+				size_t done = 0;
+				if constexpr (SIMD_FIXUP)
+				{
+					if (count >= 8)
+						done = Simd::permuteRecords((uint8_t*)items, count, sizeof(S), _permutation().data());
+				}
+				for (size_t i = done; i < count; i++)
+					(Fields::fix(items[i]), ...);
+			}
+		}
+
+	private:
+		static const std::array<uint8_t, sizeof(S)>&
+		_permutation()
+		{
+			static const std::array<uint8_t, sizeof(S)> perm = [] {
+				std::array<uint8_t, sizeof(S)> ret;
+				for (size_t i = 0; i < sizeof(S); i++)
+					ret[i] = (uint8_t)i;
+				(Fields::addToPermutation(ret.data()), ...);
+				return ret;
+			}();
+			return perm;
+		}
+	};
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace BinaryReader
+{
+	// Read-only array of T over bytes that may not be aligned for T
+	// Elements are loaded with memcpy, so any address is fine. span() gives a plain std::span when the bytes happen to be aligned
+	template <class T>
+	requires std::is_trivially_copyable_v<T>
+	class UnalignedView
+	{
+		const uint8_t* m_data;
+		size_t m_size;
+
+	public:
+		class Iterator
+		{
+			const uint8_t* m_pos;
+
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = T;
+
+			Iterator() : m_pos(nullptr) {};
+			explicit Iterator(const uint8_t* pos) : m_pos(pos) {};
+
+			T
+			operator*() const
+			{
+				T value;
+				std::memcpy(&value, m_pos, sizeof(T));
+				return value;
+			}
+
+			T operator[](difference_type n) const { return *(*this + n); }
+
+			Iterator& operator++() { m_pos += sizeof(T); return *this; }
+			Iterator operator++(int) { Iterator ret = *this; m_pos += sizeof(T); return ret; }
+			Iterator& operator--() { m_pos -= sizeof(T); return *this; }
+			Iterator operator--(int) { Iterator ret = *this; m_pos -= sizeof(T); return ret; }
+			Iterator& operator+=(difference_type n) { m_pos += n * (difference_type)sizeof(T); return *this; }
+			Iterator& operator-=(difference_type n) { m_pos -= n * (difference_type)sizeof(T); return *this; }
+			Iterator operator+(difference_type n) const { return Iterator(m_pos + n * (difference_type)sizeof(T)); }
+			Iterator operator-(difference_type n) const { return Iterator(m_pos - n * (difference_type)sizeof(T)); }
+			friend Iterator operator+(difference_type n, const Iterator& it) { return it + n; }
+			difference_type operator-(const Iterator& other) const { return (m_pos - other.m_pos) / (difference_type)sizeof(T); }
+			auto operator<=>(const Iterator&) const = default;
+		};
+
+		UnalignedView() : m_data(nullptr), m_size(0) {};
+		UnalignedView(const uint8_t* data, size_t size) : m_data(data), m_size(size) {};
+
+		T
+		operator[](size_t index) const
+		{
+			T value;
+			std::memcpy(&value, m_data + index * sizeof(T), sizeof(T));
+			return value;
+		}
+
+		T
+		at(size_t index) const
+		{
+			if (index >= m_size)
+				throw std::out_of_range("View index out of range");
+			return (*this)[index];
+		}
+
+		size_t
+		size() const
+		{
+			return m_size;
+		}
+
+		bool
+		empty() const
+		{
+			return m_size == 0;
+		}
+
+		const uint8_t*
+		bytes() const
+		{
+			return m_data;
+		}
+
+		Iterator
+		begin() const
+		{
+			return Iterator(m_data);
+		}
+
+		Iterator
+		end() const
+		{
+			return Iterator(m_data + m_size * sizeof(T));
+		}
+
+		UnalignedView
+		subview(size_t offset, size_t count) const
+		{
+			if (offset > m_size || count > m_size - offset)
+				throw std::out_of_range("Subview out of range");
+			return UnalignedView(m_data + offset * sizeof(T), count);
+		}
+
+		bool
+		isAligned() const
+		{
+			return (uintptr_t)m_data % alignof(T) == 0;
+		}
+
+		// Throws if the bytes aren't aligned for T; check isAligned() first
+		std::span<const T>
+		span() const
+		{
+			if (!isAligned())
+				throw std::logic_error("View is not aligned for this type");
+			return std::span<const T>((const T*)m_data, m_size);
+		}
+	};
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "BinaryReader.h"
+#include "BinaryReaderBlockCache.h"
+#include "BinaryReaderExceptions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BinaryReader
+{
+	// File reader that serves reads out of its own aligned window buffer (POSIX)
+	// The window is refilled with pread, so seeks are just a cursor update
+	//   and only cost I/O when they land outside the window
+	// Given a BlockCache, the window is instead the cached block under the cursor, shared with other readers of the file
+	class BinaryReaderWindowed : public BinaryReader
+	{
+		static constexpr size_t WINDOW_ALIGN = 4096;
+
+		struct WindowDeleter
+		{
+			void
+			operator()(uint8_t* ptr) const
+			{
+				::operator delete[](ptr, std::align_val_t(WINDOW_ALIGN));
+			}
+		};
+
+		int m_fd;
+		size_t m_length;
+		size_t m_curPos;
+		BlockCache* m_cache;
+		BlockCache::FileLease m_file;
+		// Points into m_window, or into m_block when cached
+		const uint8_t* m_windowPtr;
+		std::unique_ptr<uint8_t[], WindowDeleter> m_window;
+		std::shared_ptr<const BlockCache::Block> m_block;
+		size_t m_windowSize;
+		// File offset of m_windowPtr[0], and how many bytes of the window are valid
+		size_t m_windowStart;
+		size_t m_windowFill;
+
+		void
+		readBytes(void* dst, int count) override
+		{
+			if (m_curPos >= m_windowStart && m_curPos + count <= m_windowStart + m_windowFill)
+			{
+				std::memcpy(dst, m_windowPtr + (m_curPos - m_windowStart), count);
+				m_curPos += count;
+				return;
+			}
+			_readSlow((uint8_t*)dst, count);
+		}
+
+		// Exposes the rest of the window, refilling first if the cursor has left it
+		const uint8_t*
+		cursorPtr(size_t& remaining) override
+		{
+			if (m_curPos >= m_length)
+			{
+				remaining = 0;
+				return nullptr;
+			}
+			if (m_curPos < m_windowStart || m_curPos >= m_windowStart + m_windowFill)
+				_refill();
+
+			remaining = m_windowStart + m_windowFill - m_curPos;
+			return m_windowPtr + (m_curPos - m_windowStart);
+		}
+
+	public:
+		static constexpr size_t DEFAULT_WINDOW_SIZE = 256 * 1024;
+
+		BinaryReaderWindowed()
+			: m_fd(-1), m_length(0), m_curPos(0), m_cache(nullptr), m_file(), m_windowPtr(nullptr), m_window(), m_block(),
+			  m_windowSize(0), m_windowStart(0), m_windowFill(0)
+		{
+		}
+
+		// `windowSize` is rounded up to a multiple of 4 KiB
+		// With a `cache`, `windowSize` is unused: the cache's blocks are the window
+		BinaryReaderWindowed(const std::string& filePath, size_t windowSize = DEFAULT_WINDOW_SIZE, BlockCache* cache = nullptr)
+			: m_fd(-1), m_length(0), m_curPos(0), m_cache(cache), m_file(), m_windowPtr(nullptr), m_window(), m_block(),
+			  m_windowSize(0), m_windowStart(0), m_windowFill(0)
+		{
+			m_fd = ::open(filePath.c_str(), O_RDONLY);
+			if (m_fd < 0)
+				throw std::runtime_error("File does not exist");
+
+			struct stat fileStat;
+			if (::fstat(m_fd, &fileStat) != 0)
+			{
+				::close(m_fd);
+				throw std::runtime_error("Cannot stat file");
+			}
+			m_length = (size_t)fileStat.st_size;
+
+			if (m_cache != nullptr)
+			{
+				m_file = m_cache->acquireFile(fileStat);
+				m_windowSize = m_cache->blockSize();
+				return;
+			}
+			m_windowSize = std::max(WINDOW_ALIGN, (windowSize + WINDOW_ALIGN - 1) / WINDOW_ALIGN * WINDOW_ALIGN);
+			m_window.reset((uint8_t*)::operator new[](m_windowSize, std::align_val_t(WINDOW_ALIGN)));
+			m_windowPtr = m_window.get();
+		}
+
+		BinaryReaderWindowed(const BinaryReaderWindowed&) = delete;
+		BinaryReaderWindowed& operator=(const BinaryReaderWindowed&) = delete;
+
+		~BinaryReaderWindowed()
+		{
+			if (m_fd >= 0)
+				::close(m_fd);
+		}
+
+		size_t
+		getLength() override
+		{
+			return m_length;
+		}
+
+		BinaryReaderWindowed&
+		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur) override
+		{
+			_statSeek(offset, way);
+			switch (way)
+			{
+			case std::ios_base::beg:
+				m_curPos = offset;
+				break;
+			case std::ios_base::cur:
+				m_curPos += offset;
+				break;
+			case std::ios_base::end:
+				m_curPos = m_length + offset;
+				break;
+			}
+			return *this;
+		}
+
+		size_t
+		tell() override
+		{
+			return m_curPos;
+		}
+
+		// Bypasses the window, which belongs to the cursor, but not the cache
+		void
+		readBytesAt(void* dst, size_t count, size_t offset) const override
+		{
+			if (offset > m_length || count > m_length - offset)
+				throw std::out_of_range("Positional read out of bounds");
+			if (m_cache == nullptr)
+			{
+				_pread((uint8_t*)dst, count, offset);
+				return;
+			}
+			m_cache->read(m_file.id(), dst, count, offset, [this](uint8_t* blockDst, size_t size, uint64_t index) {
+				return _loadBlock(index, blockDst, size);
+			});
+		}
+
+		size_t
+		getWindowSize() const
+		{
+			return m_windowSize;
+		}
+
+	private:
+		void
+		_readSlow(uint8_t* dst, size_t count)
+		{
+			if (m_curPos + count > m_length)
+				throw std::runtime_error("Read past end of file");
+
+			while (count > 0)
+			{
+				// Large reads bypass the window entirely, unless it is the shared cache
+				if (count >= m_windowSize && m_cache == nullptr)
+				{
+					_pread(dst, count, m_curPos);
+					m_curPos += count;
+					return;
+				}
+
+				if (m_curPos < m_windowStart || m_curPos >= m_windowStart + m_windowFill)
+					_refill();
+
+				size_t available = std::min(count, m_windowStart + m_windowFill - m_curPos);
+				std::memcpy(dst, m_windowPtr + (m_curPos - m_windowStart), available);
+				dst += available;
+				count -= available;
+				m_curPos += available;
+			}
+		}
+
+		// Start the window on the page containing the cursor
+		// This keeps some bytes behind the cursor, so short backward seeks stay in memory
+		// Cached, the window is the whole block containing the cursor
+		void
+		_refill()
+		{
+			if (m_cache != nullptr)
+			{
+				uint64_t index = m_curPos / m_windowSize;
+				m_block = m_cache->get(m_file.id(), index, [&](uint8_t* dst, size_t size) {
+					return _loadBlock(index, dst, size);
+				});
+				m_windowPtr = m_block->data.get();
+				m_windowStart = index * m_windowSize;
+				m_windowFill = m_block->size;
+				// The file shrank since it was opened
+				if (m_curPos >= m_windowStart + m_windowFill)
+					throw std::runtime_error("Read past end of file");
+				return;
+			}
+
+			m_windowStart = m_curPos - (m_curPos % WINDOW_ALIGN);
+			m_windowFill = std::min(m_windowSize, m_length - m_windowStart);
+			_pread(m_window.get(), m_windowFill, m_windowStart);
+		}
+
+		// Block `index` of the file, as much of it as the file has
+		size_t
+		_loadBlock(uint64_t index, uint8_t* dst, size_t blockSize) const
+		{
+			size_t offset = index * blockSize;
+			size_t size = offset < m_length ? std::min(blockSize, m_length - offset) : 0;
+			_pread(dst, size, offset);
+			return size;
+		}
+
+		void
+		_pread(uint8_t* dst, size_t count, size_t offset) const
+		{
+			while (count > 0)
+			{
+				ssize_t got = ::pread(m_fd, dst, count, (off_t)offset);
+				if (got < 0 && errno == EINTR)
+					continue;
+				if (got <= 0)
+					throw std::runtime_error("Failed to read file");
+				dst += got;
+				count -= (size_t)got;
+				offset += (size_t)got;
+			}
+		}
+	};
+};
@@ -0,0 +1,131 @@
+// Byte-swap kernels and the big-endian array reads built on them, against a byte-by-byte reversal
+// Every count up to a few vectors, at every misalignment, so each kernel's tail is covered
+
+#include "TestCommon.h"
+
+#include "BinaryReaderSimd.h"
+#include "BinaryReaderStaticSlice.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using namespace BinaryReader;
+
+	constexpr size_t MAX_COUNT = 80;
+
+	std::vector<uint8_t>
+	randomBytes(size_t size, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<uint8_t> bytes(size);
+		for (uint8_t& b : bytes)
+			b = (uint8_t)rng();
+		return bytes;
+	}
+
+	template <size_t Size>
+	std::vector<uint8_t>
+	reversed(const uint8_t* data, size_t count)
+	{
+		std::vector<uint8_t> out(data, data + count * Size);
+		for (size_t i = 0; i < count; i++)
+			std::reverse(out.begin() + i * Size, out.begin() + (i + 1) * Size);
+		return out;
+	}
+
+	// `kernel` swaps some leading elements and returns how many; the scalar path finishes the rest
+	template <size_t Size, typename Kernel>
+	void
+	checkKernel(Kernel&& kernel)
+	{
+		std::vector<uint8_t> source = randomBytes(MAX_COUNT * Size + 16, Size);
+		for (size_t misalign = 0; misalign < 4; misalign++)
+		{
+			for (size_t count = 0; count <= MAX_COUNT; count++)
+			{
+				std::vector<uint8_t> data = source;
+				uint8_t* start = data.data() + misalign;
+				size_t done = kernel(start, count);
+				CHECK(done <= count);
+				Simd::_byteSwapScalar<Size>(start + done * Size, count - done);
+
+				std::vector<uint8_t> expected = reversed<Size>(source.data() + misalign, count);
+				CHECK(std::equal(expected.begin(), expected.end(), start));
+				// Nothing past the array is touched
+				CHECK(std::equal(data.begin() + misalign + count * Size, data.end(), source.begin() + misalign + count * Size));
+			}
+		}
+	}
+
+	template <size_t Size>
+	void
+	checkKernels()
+	{
+		checkKernel<Size>([](uint8_t*, size_t) { return (size_t)0; });
+#ifdef BINARYREADER_X86_SIMD
+		if constexpr (Size == 2 || Size == 4 || Size == 8)
+		{
+			if (Simd::hasSSSE3())
+				checkKernel<Size>([](uint8_t* data, size_t count) { return Simd::_byteSwapSSSE3<Size>(data, count); });
+			if (Simd::hasAVX2())
+				checkKernel<Size>([](uint8_t* data, size_t count) { return Simd::_byteSwapAVX2<Size>(data, count); });
+		}
+#endif
+	}
+
+	// readScalarArrayBE against one readScalarBE per element, on a memory reader and on one without cursorPtr
+	template <typename T>
+	void
+	checkArrayReads()
+	{
+		std::vector<uint8_t> bytes = randomBytes(MAX_COUNT * sizeof(T), sizeof(T) + 100);
+		for (size_t count = 1; count <= MAX_COUNT; count++)
+		{
+			BinaryReaderStaticSlice one(bytes.data(), bytes.size());
+			std::vector<T> expected(count);
+			for (T& value : expected)
+				value = one.readScalarBE<T>();
+
+			BinaryReaderStaticSlice slice(bytes.data(), bytes.size());
+			std::vector<T> fromSlice(count);
+			slice.readScalarArrayBE(fromSlice.data(), count);
+
+			Test::StreamReader stream(bytes);
+			std::vector<T> fromStream(count);
+			stream.readScalarArrayBE(fromStream.data(), count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				CHECK(Test::sameBits(fromSlice[i], expected[i]));
+				CHECK(Test::sameBits(fromStream[i], expected[i]));
+			}
+			CHECK(slice.tell() == count * sizeof(T));
+			CHECK(stream.tell() == count * sizeof(T));
+		}
+	}
+}
+
+int
+main()
+{
+	checkKernels<2>();
+	checkKernels<3>();
+	checkKernels<4>();
+	checkKernels<8>();
+	checkKernels<16>();
+
+	checkArrayReads<uint16_t>();
+	checkArrayReads<int16_t>();
+	checkArrayReads<uint32_t>();
+	checkArrayReads<int32_t>();
+	checkArrayReads<uint64_t>();
+	checkArrayReads<int64_t>();
+	checkArrayReads<float>();
+	checkArrayReads<double>();
+
+	return Test::finish();
+}
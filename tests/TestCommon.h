@@ -0,0 +1,120 @@
+#pragma once
+
+// Shared by the correctness tests
+// CHECK is not assert: it stays on under NDEBUG, reports file and line, and keeps going
+// Each test's main returns Test::finish(), which is nonzero if any check failed
+
+#include "BinaryReader.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ios>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Test
+{
+	inline int failures = 0;
+
+	inline bool
+	check(bool ok, const char* expr, const char* file, int line)
+	{
+		if (!ok)
+		{
+			// Past this many, one more line per broken element only buries the first
+			if (failures < 25)
+				std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+			failures++;
+		}
+		return ok;
+	}
+
+	inline int
+	finish()
+	{
+		if (failures != 0)
+			std::fprintf(stderr, "%d check(s) failed\n", failures);
+		return failures != 0;
+	}
+
+	// Bit-exact, so NaN payloads and -0 count
+	template <typename T>
+	inline bool
+	sameBits(const T& a, const T& b)
+	{
+		return std::memcmp(&a, &b, sizeof(T)) == 0;
+	}
+
+	// Returns true if `fn` threw an `E`
+	template <typename E, typename Fn>
+	inline bool
+	throws(Fn&& fn)
+	{
+		try
+		{
+			fn();
+		}
+		catch (const E&)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	// Memory reader without cursorPtr, so the bulk decoders fall back to their readBytes paths
+	// Always bounds-checked, whatever BINARYREADER_BOUNDS_CHECK says
+	class StreamReader : public BinaryReader::BinaryReader
+	{
+		std::vector<uint8_t> m_data;
+		size_t m_curPos;
+
+		void
+		readBytes(void* dst, int count) override
+		{
+			if (m_curPos > m_data.size() || (size_t)count > m_data.size() - m_curPos)
+				throw std::out_of_range("Read past end of data");
+			std::memcpy(dst, m_data.data() + m_curPos, count);
+			m_curPos += count;
+		}
+
+	public:
+		explicit StreamReader(std::vector<uint8_t> data)
+			: m_data(std::move(data)), m_curPos(0)
+		{
+		}
+
+		StreamReader&
+		seek(std::streamoff offset, std::ios_base::seekdir way = std::ios::cur) override
+		{
+			switch (way)
+			{
+			case std::ios_base::beg:
+				m_curPos = offset;
+				break;
+			case std::ios_base::cur:
+				m_curPos += offset;
+				break;
+			case std::ios_base::end:
+				m_curPos = m_data.size() + offset;
+				break;
+			}
+			return *this;
+		}
+
+		size_t
+		getLength() override
+		{
+			return m_data.size();
+		}
+
+		size_t
+		tell() override
+		{
+			return m_curPos;
+		}
+	};
+};
+
+#define CHECK(expr) ::Test::check((expr), #expr, __FILE__, __LINE__)
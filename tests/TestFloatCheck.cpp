@@ -0,0 +1,385 @@
+// Float Safe array checks against one readScalarSafe/readHalfSafe per element
+// For float, double and half, LE and BE, every flag combination and several ranges and exact values:
+//   the element the array read fails on, the exception it throws, where it leaves the cursor,
+//   and the fixed-up values before the failure, also when the data ends before the array does
+// The fixFloats kernels are also run directly, against the same per-element results
+// The tryRead* rows need std::expected (C++23); CMake builds this target as C++23 when the compiler can
+
+#include "TestCommon.h"
+
+#include "BinaryReaderSimd.h"
+#include "BinaryReaderStaticSlice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using namespace BinaryReader;
+	using CheckedSlice = BasicStaticSlice<Bounds::Checked>;
+
+	// Longer than a few AVX2 vectors of float, with a tail
+	constexpr size_t COUNT = 37;
+
+	enum class Outcome
+	{
+		Pass,
+		Limit,
+		NonNormal
+	};
+
+	// Either [min, max) or one exact value
+	template <typename T>
+	struct Limits
+	{
+		bool exact;
+		T min;
+		T max;
+	};
+
+	template <typename Fn>
+	Outcome
+	outcomeOf(Fn&& fn)
+	{
+		try
+		{
+			fn();
+		}
+		catch (const LimitException&)
+		{
+			return Outcome::Limit;
+		}
+		catch (const NonNormalFloatException&)
+		{
+			return Outcome::NonNormal;
+		}
+		return Outcome::Pass;
+	}
+
+	// float or double, stored as is
+	template <typename T, bool Big>
+	struct FloatFormat
+	{
+		using Stored = T;
+		using Out = T;
+		static constexpr bool BIG = Big;
+
+		template <class Reader>
+		static Out
+		readOne(Reader& reader, const Limits<Out>& limits, uint8_t flags)
+		{
+			if constexpr (Big)
+				return limits.exact ? reader.template readScalarBESafe<T>(limits.min, flags, "one")
+					: reader.template readScalarBESafe<T>(limits.min, limits.max, flags, "one");
+			else
+				return limits.exact ? reader.template readScalarSafe<T>(limits.min, flags, "one")
+					: reader.template readScalarSafe<T>(limits.min, limits.max, flags, "one");
+		}
+
+		template <class Reader>
+		static void
+		readArray(Reader& reader, Out* dst, size_t count, const Limits<Out>& limits, uint8_t flags)
+		{
+			if constexpr (Big)
+			{
+				if (limits.exact)
+					reader.template readScalarArrayBESafe<T>(dst, count, limits.min, flags, "array");
+				else
+					reader.template readScalarArrayBESafe<T>(dst, count, limits.min, limits.max, flags, "array");
+			}
+			else
+			{
+				if (limits.exact)
+					reader.template readScalarArraySafe<T>(dst, count, limits.min, flags, "array");
+				else
+					reader.template readScalarArraySafe<T>(dst, count, limits.min, limits.max, flags, "array");
+			}
+		}
+
+#ifdef BINARYREADER_HAS_EXPECTED
+		template <class Reader>
+		static auto
+		tryReadArray(Reader& reader, Out* dst, size_t count, const Limits<Out>& limits, uint8_t flags)
+		{
+			if constexpr (Big)
+				return limits.exact ? reader.template tryReadScalarArrayBE<T>(dst, count, limits.min, flags)
+					: reader.template tryReadScalarArrayBE<T>(dst, count, limits.min, limits.max, flags);
+			else
+				return limits.exact ? reader.template tryReadScalarArray<T>(dst, count, limits.min, flags)
+					: reader.template tryReadScalarArray<T>(dst, count, limits.min, limits.max, flags);
+		}
+#endif
+
+		static std::vector<Stored>
+		pool()
+		{
+			using L = std::numeric_limits<T>;
+			std::vector<T> values = { 0, -T(0), 1, -1, T(0.5), 100, T(99.5), -100, T(3.25), T(1e30), T(-1e-30),
+				L::min(), -L::min(), L::denorm_min(), -L::denorm_min(), L::min() - L::denorm_min(),
+				L::max(), L::lowest(), L::infinity(), -L::infinity(), L::quiet_NaN(), -L::quiet_NaN(), L::signaling_NaN(),
+				std::nextafter(T(1), T(0)), std::nextafter(T(-1), T(0)), std::nextafter(T(100), T(0)), std::nextafter(T(0), T(1)) };
+			return values;
+		}
+	};
+
+	// Halfs, widened to float
+	template <bool Big>
+	struct HalfFormat
+	{
+		using Stored = uint16_t;
+		using Out = float;
+		static constexpr bool BIG = Big;
+
+		template <class Reader>
+		static Out
+		readOne(Reader& reader, const Limits<Out>& limits, uint8_t flags)
+		{
+			if constexpr (Big)
+				return limits.exact ? reader.readHalfBESafe(limits.min, flags, "one") : reader.readHalfBESafe(limits.min, limits.max, flags, "one");
+			else
+				return limits.exact ? reader.readHalfSafe(limits.min, flags, "one") : reader.readHalfSafe(limits.min, limits.max, flags, "one");
+		}
+
+		template <class Reader>
+		static void
+		readArray(Reader& reader, Out* dst, size_t count, const Limits<Out>& limits, uint8_t flags)
+		{
+			if constexpr (Big)
+			{
+				if (limits.exact)
+					reader.readHalfArrayBESafe(dst, count, limits.min, flags, "array");
+				else
+					reader.readHalfArrayBESafe(dst, count, limits.min, limits.max, flags, "array");
+			}
+			else
+			{
+				if (limits.exact)
+					reader.readHalfArraySafe(dst, count, limits.min, flags, "array");
+				else
+					reader.readHalfArraySafe(dst, count, limits.min, limits.max, flags, "array");
+			}
+		}
+
+#ifdef BINARYREADER_HAS_EXPECTED
+		template <class Reader>
+		static auto
+		tryReadArray(Reader& reader, Out* dst, size_t count, const Limits<Out>& limits, uint8_t flags)
+		{
+			if constexpr (Big)
+				return limits.exact ? reader.tryReadHalfArrayBE(dst, count, limits.min, flags)
+					: reader.tryReadHalfArrayBE(dst, count, limits.min, limits.max, flags);
+			else
+				return limits.exact ? reader.tryReadHalfArray(dst, count, limits.min, flags)
+					: reader.tryReadHalfArray(dst, count, limits.min, limits.max, flags);
+		}
+#endif
+
+		// Both signs of every exponent, with the mantissas at either end and in the middle
+		// TestHalf covers all 65536 conversions; here each value costs a Safe read per configuration
+		static std::vector<Stored>
+		pool()
+		{
+			std::vector<Stored> values;
+			for (uint16_t top = 0; top < 64; top++)
+			{
+				for (uint16_t mantissa : { 0x000, 0x001, 0x002, 0x1ff, 0x200, 0x3fe, 0x3ff })
+					values.push_back((uint16_t)(top << 10 | mantissa));
+			}
+			return values;
+		}
+	};
+
+	template <typename T>
+	std::vector<Limits<T>>
+	limitsToCheck()
+	{
+		using L = std::numeric_limits<T>;
+		return {
+			{ false, -L::infinity(), L::infinity() },
+			{ false, L::lowest(), L::max() },
+			{ false, -1, 1 },
+			{ false, 0, 100 },
+			{ true, 1, 0 },
+			{ true, 0, 0 },
+			{ true, -T(0), 0 },
+		};
+	}
+
+	template <class Format>
+	std::vector<uint8_t>
+	encode(const std::vector<typename Format::Stored>& values)
+	{
+		using Stored = typename Format::Stored;
+		std::vector<uint8_t> bytes(values.size() * sizeof(Stored));
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			Stored v = Format::BIG ? Simd::byteSwap(values[i]) : values[i];
+			std::memcpy(bytes.data() + i * sizeof(Stored), &v, sizeof(Stored));
+		}
+		return bytes;
+	}
+
+	// The reference for one stored value: what readScalarSafe/readHalfSafe makes of it
+	template <class Format>
+	struct Expected
+	{
+		Outcome outcome;
+		typename Format::Out fixed;
+	};
+
+	template <class Format>
+	Expected<Format>
+	readEach(typename Format::Stored value, const Limits<typename Format::Out>& limits, uint8_t flags)
+	{
+		std::vector<uint8_t> bytes = encode<Format>({ value });
+		BinaryReaderStaticSlice reader(bytes.data(), bytes.size());
+		Expected<Format> out = { Outcome::Pass, 0 };
+		out.outcome = outcomeOf([&] { out.fixed = Format::readOne(reader, limits, flags); });
+		return out;
+	}
+
+	template <class Format, class Reader>
+	void
+	checkArrayRead(Reader& reader, const std::vector<Expected<Format>>& expected, const Limits<typename Format::Out>& limits,
+		uint8_t flags)
+	{
+		using Stored = typename Format::Stored;
+		size_t fail = 0;
+		while (fail < expected.size() && expected[fail].outcome == Outcome::Pass)
+			fail++;
+
+		std::vector<typename Format::Out> dst(expected.size());
+		Outcome outcome = outcomeOf([&] { Format::readArray(reader, dst.data(), dst.size(), limits, flags); });
+		CHECK(outcome == (fail < expected.size() ? expected[fail].outcome : Outcome::Pass));
+		CHECK(reader.tell() == std::min(fail + 1, expected.size()) * sizeof(Stored));
+		for (size_t i = 0; i < fail; i++)
+			CHECK(Test::sameBits(dst[i], expected[i].fixed));
+	}
+
+	// Kernels on the values the array read would have loaded, for float and double only
+	template <class Format>
+	void
+	checkKernels(const std::vector<typename Format::Stored>& values, const std::vector<Expected<Format>>& expected,
+		const Limits<typename Format::Out>& limits, uint8_t flags)
+	{
+		using T = typename Format::Out;
+		size_t fail = 0;
+		while (fail < expected.size() && expected[fail].outcome == Outcome::Pass)
+			fail++;
+
+		// The same keys BasicReader::_readValidFloatArray hands to fixFloats
+		Simd::FloatKey<T> keyMin = Simd::floatKey(limits.min);
+		Simd::FloatKey<T> keyMax = limits.exact ? keyMin + 1 : Simd::floatKey(limits.max);
+		bool convertInf = flags & CONV_INF, convertZero = flags & CONV_ZERO, failSubnormal = flags & FAIL_SUBNORM;
+
+		std::vector<T> data = values;
+		size_t found = Simd::fixFloats(data.data(), data.size(), keyMin, keyMax, convertInf, convertZero, failSubnormal);
+		CHECK(found == fail);
+		for (size_t i = 0; i < std::min(found, fail); i++)
+			CHECK(Test::sameBits(data[i], expected[i].fixed));
+		// The failing element is left as it was loaded
+		if (found < data.size())
+			CHECK(Test::sameBits(data[found], values[found]));
+
+#ifdef BINARYREADER_X86_SIMD
+		if (Simd::hasAVX2())
+		{
+			data = values;
+			size_t known = Simd::_fixFloatsAVX2(data.data(), data.size(), keyMin, keyMax, convertInf, convertZero, failSubnormal);
+			CHECK(known <= fail);
+			CHECK(fail - known < 32 / sizeof(T) || fail == data.size());
+			for (size_t i = 0; i < known; i++)
+				CHECK(Test::sameBits(data[i], expected[i].fixed));
+		}
+#endif
+	}
+
+	template <class Format>
+	void
+	checkFormat()
+	{
+		using Stored = typename Format::Stored;
+		using Out = typename Format::Out;
+		const std::vector<Stored> pool = Format::pool();
+		std::mt19937 rng(sizeof(Stored) * 2 + Format::BIG);
+
+		for (const Limits<Out>& limits : limitsToCheck<Out>())
+		{
+			for (uint8_t flags = 0; flags <= (CONV_INF | CONV_ZERO | FAIL_SUBNORM); flags++)
+			{
+				std::vector<Expected<Format>> each(pool.size());
+				std::vector<Stored> passing;
+				std::vector<Stored> failing;
+				for (size_t i = 0; i < pool.size(); i++)
+				{
+					each[i] = readEach<Format>(pool[i], limits, flags);
+					(each[i].outcome == Outcome::Pass ? passing : failing).push_back(pool[i]);
+				}
+				if (passing.empty() || failing.empty())
+					continue;
+
+				// Passing values with one failure planted at each position, and sometimes a second one later on
+				for (size_t at = 0; at <= COUNT; at++)
+				{
+					std::vector<Stored> values(COUNT);
+					for (Stored& v : values)
+						v = passing[rng() % passing.size()];
+					if (at < COUNT)
+						values[at] = failing[rng() % failing.size()];
+					if (at + 5 < COUNT && rng() % 2 == 0)
+						values[at + 5] = failing[rng() % failing.size()];
+
+					std::vector<Expected<Format>> expected(COUNT);
+					for (size_t i = 0; i < COUNT; i++)
+						expected[i] = readEach<Format>(values[i], limits, flags);
+
+					std::vector<uint8_t> bytes = encode<Format>(values);
+					BinaryReaderStaticSlice slice(bytes.data(), bytes.size());
+					checkArrayRead<Format>(slice, expected, limits, flags);
+					Test::StreamReader stream(bytes);
+					checkArrayRead<Format>(stream, expected, limits, flags);
+
+					// The data ends soon after the failure, mid-element: it is still reported ahead of the read error
+					if (at + 2 < COUNT)
+					{
+						std::vector<uint8_t> cut(bytes.begin(), bytes.begin() + (at + 2) * sizeof(Stored) + 1);
+						CheckedSlice cutSlice(cut.data(), cut.size());
+						checkArrayRead<Format>(cutSlice, expected, limits, flags);
+						Test::StreamReader cutStream(cut);
+						checkArrayRead<Format>(cutStream, expected, limits, flags);
+					}
+
+#ifdef BINARYREADER_HAS_EXPECTED
+					BinaryReaderStaticSlice tried(bytes.data(), bytes.size());
+					std::vector<Out> dst(COUNT);
+					auto result = Format::tryReadArray(tried, dst.data(), COUNT, limits, flags);
+					CHECK(result.has_value() == (at == COUNT));
+					if (!result)
+						CHECK(result.error().index == at);
+					CHECK(tried.tell() == std::min(at + 1, COUNT) * sizeof(Stored));
+#endif
+
+					if constexpr (std::is_same_v<Stored, Out>)
+						checkKernels<Format>(values, expected, limits, flags);
+				}
+			}
+		}
+	}
+}
+
+int
+main()
+{
+	checkFormat<FloatFormat<float, false>>();
+	checkFormat<FloatFormat<float, true>>();
+	checkFormat<FloatFormat<double, false>>();
+	checkFormat<FloatFormat<double, true>>();
+	checkFormat<HalfFormat<false>>();
+	checkFormat<HalfFormat<true>>();
+
+	return Test::finish();
+}
@@ -0,0 +1,131 @@
+// Half-float conversion over all 65536 inputs, every kernel against readHalf (BasicReader::_readHalfFloat)
+// Compared bit for bit, so NaN payloads, infinities, -0 and subnormals all have to match
+
+#include "TestCommon.h"
+
+#include "BinaryReaderSimd.h"
+#include "BinaryReaderStaticSlice.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	using namespace BinaryReader;
+
+	constexpr size_t HALF_COUNT = 65536;
+
+	// The reference: one readHalf per value
+	std::vector<float>
+	expectedFloats(const std::vector<uint16_t>& halfs)
+	{
+		BinaryReaderStaticSlice reader((const uint8_t*)halfs.data(), halfs.size() * sizeof(uint16_t));
+		std::vector<float> floats(halfs.size());
+		for (float& f : floats)
+			f = reader.readHalf();
+		return floats;
+	}
+
+	void
+	checkAll(const std::vector<float>& got, const std::vector<float>& expected)
+	{
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			if (!CHECK(Test::sameBits(got[i], expected[i])) && Test::failures <= 25)
+				std::fprintf(stderr, "  half 0x%04zx\n", i);
+		}
+	}
+
+	// `kernel` converts some leading elements and returns how many; the scalar conversion finishes the rest
+	template <typename Kernel>
+	void
+	checkKernel(const std::vector<uint16_t>& halfs, const std::vector<float>& expected, Kernel&& kernel)
+	{
+		std::vector<float> floats(halfs.size());
+		size_t done = kernel(halfs.data(), floats.data(), halfs.size());
+		CHECK(done <= halfs.size());
+		for (size_t i = done; i < halfs.size(); i++)
+			floats[i] = Simd::halfToFloat(halfs[i]);
+		checkAll(floats, expected);
+
+		// Short counts and tails, converted in place from the upper half like readHalfArray does
+		for (size_t count = 0; count <= 40; count++)
+		{
+			std::vector<float> buf(count);
+			uint16_t* raw = (uint16_t*)buf.data() + count;
+			for (size_t i = 0; i < count; i++)
+				raw[i] = halfs[0x3c00 + i * 997 % 0x4000];
+			done = kernel(raw, buf.data(), count);
+			for (size_t i = done; i < count; i++)
+				buf[i] = Simd::halfToFloat(halfs[0x3c00 + i * 997 % 0x4000]);
+			for (size_t i = 0; i < count; i++)
+				CHECK(Test::sameBits(buf[i], expected[0x3c00 + i * 997 % 0x4000]));
+		}
+	}
+
+	// readHalfArray(BE) against readHalf(BE), on a memory reader and on one without cursorPtr
+	template <bool Big>
+	void
+	checkArrayReads(const std::vector<uint16_t>& halfs)
+	{
+		std::vector<uint8_t> bytes(halfs.size() * sizeof(uint16_t));
+		for (size_t i = 0; i < halfs.size(); i++)
+		{
+			uint16_t h = Big ? Simd::bswap16(halfs[i]) : halfs[i];
+			std::memcpy(bytes.data() + i * 2, &h, 2);
+		}
+
+		BinaryReaderStaticSlice one(bytes.data(), bytes.size());
+		std::vector<float> expected(halfs.size());
+		for (float& f : expected)
+			f = Big ? one.readHalfBE() : one.readHalf();
+		checkAll(expected, expectedFloats(halfs));
+
+		BinaryReaderStaticSlice slice(bytes.data(), bytes.size());
+		std::vector<float> fromSlice(halfs.size());
+		Test::StreamReader stream(bytes);
+		std::vector<float> fromStream(halfs.size());
+		if constexpr (Big)
+		{
+			slice.readHalfArrayBE(fromSlice.data(), fromSlice.size());
+			stream.readHalfArrayBE(fromStream.data(), fromStream.size());
+		}
+		else
+		{
+			slice.readHalfArray(fromSlice.data(), fromSlice.size());
+			stream.readHalfArray(fromStream.data(), fromStream.size());
+		}
+		checkAll(fromSlice, expected);
+		checkAll(fromStream, expected);
+		CHECK(slice.tell() == bytes.size());
+		CHECK(stream.tell() == bytes.size());
+	}
+}
+
+int
+main()
+{
+	std::vector<uint16_t> halfs(HALF_COUNT);
+	for (size_t i = 0; i < HALF_COUNT; i++)
+		halfs[i] = (uint16_t)i;
+	std::vector<float> expected = expectedFloats(halfs);
+
+	checkKernel(halfs, expected, [](const uint16_t*, float*, size_t) { return (size_t)0; });
+	checkKernel(halfs, expected, [](const uint16_t* src, float* dst, size_t count) {
+		Simd::halfToFloatArray(src, dst, count);
+		return count;
+	});
+#ifdef BINARYREADER_X86_SIMD
+	if (Simd::hasSSE2())
+		checkKernel(halfs, expected, [](const uint16_t* src, float* dst, size_t count) { return Simd::_halfToFloatSSE2(src, dst, count); });
+	if (Simd::hasAVX2())
+		checkKernel(halfs, expected, [](const uint16_t* src, float* dst, size_t count) { return Simd::_halfToFloatAVX2(src, dst, count); });
+	if (Simd::hasAVX2() && Simd::hasF16C())
+		checkKernel(halfs, expected, [](const uint16_t* src, float* dst, size_t count) { return Simd::_halfToFloatF16C(src, dst, count); });
+#endif
+
+	checkArrayReads<false>(halfs);
+	checkArrayReads<true>(halfs);
+
+	return Test::finish();
+}
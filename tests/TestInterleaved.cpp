@@ -0,0 +1,194 @@
+// Interleaved records: the strided gather kernels against a plain copy per record, and readInterleaved
+//   against reading every component of every record on its own
+// Large reads span several 64 KiB blocks, on a memory reader (decoded in place) and on one without
+//   cursorPtr (copied in chunks first)
+
+#include "TestCommon.h"
+
+#include "BinaryReaderInterleaved.h"
+#include "BinaryReaderSimd.h"
+#include "BinaryReaderStaticSlice.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using namespace BinaryReader;
+
+	constexpr size_t MAX_COUNT = 40;
+	// Bytes after each output, which no kernel may write
+	constexpr size_t GUARD = 64;
+
+	std::vector<uint8_t>
+	randomBytes(size_t size, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<uint8_t> bytes(size);
+		for (uint8_t& b : bytes)
+			b = (uint8_t)rng();
+		return bytes;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// Gather kernels
+
+	// `kernel` copies some leading records and returns how many; a plain copy finishes the rest
+	template <typename Kernel>
+	void
+	checkGather(size_t stride, size_t width, Kernel&& kernel)
+	{
+		std::vector<uint8_t> src = randomBytes(MAX_COUNT * stride + 8, (uint32_t)(stride * 64 + width));
+		for (size_t count = 0; count <= MAX_COUNT; count++)
+		{
+			std::vector<uint8_t> expected(count * width + GUARD, 0xcd);
+			for (size_t i = 0; i < count; i++)
+				std::memcpy(expected.data() + i * width, src.data() + 3 + i * stride, width);
+
+			std::vector<uint8_t> dst(count * width + GUARD, 0xcd);
+			size_t done = kernel(dst.data(), src.data() + 3, count);
+			CHECK(done <= count);
+			for (size_t i = done; i < count; i++)
+				std::memcpy(dst.data() + i * width, src.data() + 3 + i * stride, width);
+			CHECK(dst == expected);
+		}
+	}
+
+	void
+	checkGathers()
+	{
+		for (size_t width : { 1, 2, 3, 4, 6, 8, 12, 16, 20 })
+		{
+			for (size_t stride = width; stride <= 48; stride++)
+			{
+				checkGather(stride, width, [&](uint8_t* dst, const uint8_t* src, size_t count) {
+					Simd::_gatherScalar(dst, src, stride, width, count);
+					return count;
+				});
+				checkGather(stride, width, [&](uint8_t* dst, const uint8_t* src, size_t count) {
+					Simd::gatherStrided(dst, src, stride, width, count);
+					return count;
+				});
+#ifdef BINARYREADER_X86_SIMD
+				if (width % 4 == 0 && width <= 16 && Simd::hasAVX2())
+				{
+					checkGather(stride, width, [&](uint8_t* dst, const uint8_t* src, size_t count) {
+						return Simd::_gatherAVX2(dst, src, stride, width, count);
+					});
+				}
+#endif
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// readInterleaved
+
+	// 32-byte vertex, every attribute type the format mixes
+	constexpr size_t STRIDE = 32;
+
+	struct Vertices
+	{
+		std::vector<float> position;   // float3 LE at 0
+		std::vector<float> normal;     // half3 BE at 12
+		std::vector<uint16_t> uv;      // uint16x2 BE at 18
+		std::vector<uint8_t> color;    // uint8x4 at 22
+		std::vector<int32_t> id;       // int32 BE at 26, then 2 bytes of padding
+
+		explicit Vertices(size_t count)
+			: position(count * 3), normal(count * 3), uv(count * 2), color(count * 4), id(count)
+		{
+		}
+	};
+
+	// The reference: each component read on its own at its offset
+	Vertices
+	readEachComponent(const std::vector<uint8_t>& bytes, size_t count)
+	{
+		Vertices out(count);
+		BinaryReaderStaticSlice reader(bytes.data(), bytes.size());
+		for (size_t i = 0; i < count; i++)
+		{
+			reader.seek(i * STRIDE, std::ios::beg);
+			for (size_t c = 0; c < 3; c++)
+				out.position[i * 3 + c] = reader.readScalar<float>();
+			for (size_t c = 0; c < 3; c++)
+				out.normal[i * 3 + c] = reader.readHalfBE();
+			for (size_t c = 0; c < 2; c++)
+				out.uv[i * 2 + c] = reader.readScalarBE<uint16_t>();
+			for (size_t c = 0; c < 4; c++)
+				out.color[i * 4 + c] = reader.readScalar<uint8_t>();
+			out.id[i] = reader.readScalarBE<int32_t>();
+		}
+		return out;
+	}
+
+	template <class Reader>
+	Vertices
+	readAll(Reader& reader, size_t count)
+	{
+		Vertices out(count);
+		reader.readInterleaved(STRIDE, count, {
+			Attribute::of(0, 3, out.position.data()),
+			Attribute::half(12, 3, out.normal.data(), std::endian::big),
+			Attribute::of(18, 2, out.uv.data(), std::endian::big),
+			Attribute::of(22, 4, out.color.data()),
+			Attribute::of(26, 1, out.id.data(), std::endian::big),
+		});
+		CHECK(reader.tell() == count * STRIDE);
+		return out;
+	}
+
+	template <typename T>
+	bool
+	sameArray(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	void
+	checkVertices(const Vertices& got, const Vertices& expected)
+	{
+		CHECK(sameArray(got.position, expected.position));
+		CHECK(sameArray(got.normal, expected.normal));
+		CHECK(sameArray(got.uv, expected.uv));
+		CHECK(sameArray(got.color, expected.color));
+		CHECK(sameArray(got.id, expected.id));
+	}
+
+	void
+	checkReadInterleaved()
+	{
+		// 5000 records are 160 KB: several blocks, and a partial one at the end
+		std::vector<uint8_t> bytes = randomBytes(5000 * STRIDE, 16);
+		for (size_t count : { 0, 1, 7, 8, 9, 31, 2047, 2048, 2049, 5000 })
+		{
+			Vertices expected = readEachComponent(bytes, count);
+
+			BinaryReaderStaticSlice slice(bytes.data(), bytes.size());
+			checkVertices(readAll(slice, count), expected);
+
+			Test::StreamReader stream(bytes);
+			checkVertices(readAll(stream, count), expected);
+		}
+
+		// One attribute filling the whole record: a single copy
+		BinaryReaderStaticSlice packed(bytes.data(), bytes.size());
+		std::vector<uint32_t> words(100 * 8);
+		packed.readInterleaved(STRIDE, 100, { Attribute::of(0, 8, words.data(), std::endian::big) });
+		BinaryReaderStaticSlice one(bytes.data(), bytes.size());
+		for (uint32_t word : words)
+			CHECK(word == one.readScalarBE<uint32_t>());
+	}
+}
+
+int
+main()
+{
+	checkGathers();
+	checkReadInterleaved();
+
+	return Test::finish();
+}
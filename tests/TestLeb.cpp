@@ -0,0 +1,263 @@
+// LEB128 array decoding against the scalar readULEB/readSLEB, which defines the format
+// Byte streams cover every encoded length, values at the 7-bit group boundaries, overlong encodings,
+//   random continuation densities and input that ends mid-value, each under several maxBits
+// Every array path has to land on the same values and the same cursor as one scalar read per value
+// readULEBArraySafe reports the first value out of range even when the data ends in a partial value after it
+
+#include "TestCommon.h"
+
+#include "BinaryReaderLeb.h"
+#include "BinaryReaderStaticSlice.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	using namespace BinaryReader;
+	using CheckedSlice = BasicStaticSlice<Bounds::Checked>;
+
+	constexpr int MAX_BITS[] = { 64, 63, 33, 32, 16, 8, 7 };
+
+	template <bool Signed>
+	using Value = std::conditional_t<Signed, int64_t, uint64_t>;
+
+	// Each complete value in the stream, and the offset just past it
+	template <bool Signed>
+	struct Decoded
+	{
+		std::vector<Value<Signed>> values;
+		std::vector<size_t> ends;
+	};
+
+	template <bool Signed, class Reader>
+	Value<Signed>
+	readOne(Reader& reader, int maxBits)
+	{
+		if constexpr (Signed)
+			return reader.readSLEB(maxBits);
+		else
+			return reader.readULEB(maxBits);
+	}
+
+	template <bool Signed, class Reader>
+	void
+	readArray(Reader& reader, Value<Signed>* dst, size_t count, int maxBits)
+	{
+		if constexpr (Signed)
+			reader.readSLEBArray(dst, count, maxBits);
+		else
+			reader.readULEBArray(dst, count, maxBits);
+	}
+
+	template <bool Signed>
+	size_t
+	decodeArray(const uint8_t* src, size_t avail, Value<Signed>* dst, size_t count, size_t& decoded, int maxBits)
+	{
+		if constexpr (Signed)
+			return Leb::decodeSLEBArray(src, avail, dst, count, decoded, maxBits);
+		else
+			return Leb::decodeULEBArray(src, avail, dst, count, decoded, maxBits);
+	}
+
+	// The reference: scalar reads until the data runs out
+	template <bool Signed>
+	Decoded<Signed>
+	scalarDecode(const std::vector<uint8_t>& bytes, int maxBits)
+	{
+		Decoded<Signed> out;
+		Test::StreamReader reader(bytes);
+		try
+		{
+			while (reader.tell() < bytes.size())
+			{
+				Value<Signed> v = readOne<Signed>(reader, maxBits);
+				out.values.push_back(v);
+				out.ends.push_back(reader.tell());
+			}
+		}
+		catch (const std::out_of_range&)
+		{
+			// Trailing partial value
+		}
+		return out;
+	}
+
+	template <bool Signed, class Reader>
+	void
+	checkReader(Reader& reader, const Decoded<Signed>& expected, size_t count, int maxBits)
+	{
+		std::vector<Value<Signed>> dst(count);
+		readArray<Signed>(reader, dst.data(), count, maxBits);
+		for (size_t i = 0; i < count; i++)
+			CHECK(dst[i] == expected.values[i]);
+		CHECK(reader.tell() == (count == 0 ? 0 : expected.ends[count - 1]));
+	}
+
+	// Values from `at` on fail a [0, values[at]) check; the data is cut to end in a partial value after `at`
+	template <class Reader>
+	void
+	checkSafeRead(Reader& reader, const Decoded<false>& expected, size_t at, int maxBits)
+	{
+		uint64_t max = expected.values[at];
+		size_t fail = 0;
+		while (expected.values[fail] < max)
+			fail++;
+
+		std::vector<uint64_t> dst(at + 2);
+		size_t index = dst.size();
+		try
+		{
+			reader.readULEBArraySafe(dst.data(), dst.size(), 0, max, "leb", maxBits);
+		}
+		catch (const LimitException& e)
+		{
+			index = e.index;
+		}
+		CHECK(index == fail);
+		CHECK(reader.tell() == expected.ends[fail]);
+	}
+
+	void
+	checkSafe(const std::vector<uint8_t>& bytes, const Decoded<false>& expected, int maxBits)
+	{
+		for (size_t at : { (size_t)0, expected.values.size() / 2, expected.values.size() - 1 })
+		{
+			if (at >= expected.values.size())
+				continue;
+			std::vector<uint8_t> cut(bytes.begin(), bytes.begin() + expected.ends[at]);
+			cut.push_back(0x80);
+
+			CheckedSlice slice(cut.data(), cut.size());
+			checkSafeRead(slice, expected, at, maxBits);
+			Test::StreamReader stream(cut);
+			checkSafeRead(stream, expected, at, maxBits);
+		}
+	}
+
+	template <bool Signed>
+	void
+	checkStream(const std::vector<uint8_t>& bytes, int maxBits)
+	{
+		Decoded<Signed> expected = scalarDecode<Signed>(bytes, maxBits);
+		size_t all = expected.values.size();
+
+		// Whole stream and a few shorter counts, around the 8-value fast path
+		for (size_t count : { all, all / 2, (size_t)0, (size_t)1, (size_t)7, (size_t)8, (size_t)9, (size_t)17 })
+		{
+			if (count > all)
+				continue;
+			CheckedSlice slice(bytes.data(), bytes.size());
+			checkReader<Signed>(slice, expected, count, maxBits);
+			Test::StreamReader stream(bytes);
+			checkReader<Signed>(stream, expected, count, maxBits);
+		}
+
+		// One value more than the data holds: both paths run out
+		std::vector<Value<Signed>> dst(all + 1);
+		CheckedSlice slice(bytes.data(), bytes.size());
+		CHECK(Test::throws<std::out_of_range>([&] { readArray<Signed>(slice, dst.data(), all + 1, maxBits); }));
+		Test::StreamReader stream(bytes);
+		CHECK(Test::throws<std::out_of_range>([&] { readArray<Signed>(stream, dst.data(), all + 1, maxBits); }));
+
+		// The decoder on its own, with the buffer cut at every byte: only values that fit are decoded
+		for (size_t avail = 0; avail <= std::min<size_t>(bytes.size(), 96); avail++)
+		{
+			size_t fits = 0;
+			while (fits < all && expected.ends[fits] <= avail)
+				fits++;
+
+			std::vector<Value<Signed>> out(all + 1);
+			size_t decoded = 0;
+			size_t used = decodeArray<Signed>(bytes.data(), avail, out.data(), all + 1, decoded, maxBits);
+			CHECK(decoded == fits);
+			CHECK(used == (fits == 0 ? 0 : expected.ends[fits - 1]));
+			for (size_t i = 0; i < decoded && i < fits; i++)
+				CHECK(out[i] == expected.values[i]);
+		}
+
+		if constexpr (!Signed)
+			checkSafe(bytes, expected, maxBits);
+	}
+
+	void
+	appendULEB(std::vector<uint8_t>& bytes, uint64_t value)
+	{
+		do
+		{
+			uint8_t b = value & 0x7f;
+			value >>= 7;
+			bytes.push_back(value != 0 ? (uint8_t)(b | 0x80) : b);
+		} while (value != 0);
+	}
+
+	std::vector<std::vector<uint8_t>>
+	streams()
+	{
+		std::vector<std::vector<uint8_t>> out;
+
+		// Every encoded length, at and either side of each group boundary
+		std::vector<uint8_t> boundaries;
+		for (int k = 1; k <= 10; k++)
+		{
+			uint64_t edge = k < 10 ? 1ull << (7 * k) : ~0ull;
+			appendULEB(boundaries, edge - 1);
+			appendULEB(boundaries, edge);
+			appendULEB(boundaries, edge + 1);
+		}
+		out.push_back(boundaries);
+
+		// Overlong: zero padded with continuation bytes, then runs longer than any maxBits allows
+		std::vector<uint8_t> overlong;
+		for (int pad = 1; pad <= 11; pad++)
+		{
+			overlong.insert(overlong.end(), pad, 0x80);
+			overlong.push_back(0x00);
+		}
+		for (int run = 8; run <= 12; run++)
+		{
+			overlong.insert(overlong.end(), run, 0xff);
+			overlong.push_back(0x7f);
+		}
+		out.push_back(overlong);
+
+		// Single-byte values: the 8-at-a-time path, then a tail
+		std::vector<uint8_t> small;
+		for (int i = 0; i < 37; i++)
+			small.push_back((uint8_t)(i * 3 % 128));
+		out.push_back(small);
+
+		// Random bytes with the continuation bit set at different rates; most end mid-value
+		std::mt19937 rng(7);
+		for (int percent : { 0, 10, 30, 50, 70, 90, 99 })
+		{
+			std::vector<uint8_t> bytes(1500);
+			for (uint8_t& b : bytes)
+			{
+				b = (uint8_t)(rng() & 0x7f);
+				if ((int)(rng() % 100) < percent)
+					b |= 0x80;
+			}
+			out.push_back(bytes);
+		}
+		return out;
+	}
+}
+
+int
+main()
+{
+	for (const std::vector<uint8_t>& bytes : streams())
+	{
+		for (int maxBits : MAX_BITS)
+		{
+			checkStream<false>(bytes, maxBits);
+			checkStream<true>(bytes, maxBits);
+		}
+	}
+
+	return Test::finish();
+}
@@ -0,0 +1,270 @@
+// Integer range checks against a plain loop, for every integer width, signed and unsigned
+// A failing value is planted at every position of an array longer than one AVX2 block, so the
+//   kernel's early exit and the scalar rescan after it are both covered
+// Then the Safe array reads: which index they report, and where they leave the cursor, also when
+//   the data ends before the array does
+
+#include "TestCommon.h"
+
+#include "BinaryReaderSimd.h"
+#include "BinaryReaderStaticSlice.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	using namespace BinaryReader;
+	using CheckedSlice = BasicStaticSlice<Bounds::Checked>;
+
+	// Longer than one 4-vector block of int8 (128 elements), with a tail
+	constexpr size_t COUNT = 160;
+
+	template <typename T>
+	struct Range
+	{
+		T min;
+		T max;
+	};
+
+	template <typename T>
+	size_t
+	scalarOutOfRange(const std::vector<T>& data, size_t count, T min, T max)
+	{
+		size_t i = 0;
+		while (i < count && data[i] >= min && data[i] < max)
+			i++;
+		return i;
+	}
+
+	template <typename T>
+	size_t
+	scalarNotEqual(const std::vector<T>& data, size_t count, T exact)
+	{
+		size_t i = 0;
+		while (i < count && data[i] == exact)
+			i++;
+		return i;
+	}
+
+	// [min, max) wide, straddling zero or the sign bit, and small
+	template <typename T>
+	std::vector<Range<T>>
+	ranges()
+	{
+		using Limits = std::numeric_limits<T>;
+		const T mid = std::is_signed_v<T> ? (T)0 : (T)((T)1 << (sizeof(T) * 8 - 1));
+		return {
+			{ Limits::min(), Limits::max() },
+			{ (T)(mid - 3), (T)(mid + 5) },
+			{ (T)1, (T)100 },
+		};
+	}
+
+	template <typename T>
+	std::vector<T>
+	passingValues(Range<T> range, size_t count, std::mt19937_64& rng)
+	{
+		using U = std::make_unsigned_t<T>;
+		U span = (U)((U)range.max - (U)range.min);
+		std::vector<T> data(count);
+		for (T& v : data)
+			v = (T)((U)range.min + (U)(rng() % span));
+		return data;
+	}
+
+	template <typename T>
+	std::vector<T>
+	failingValues(Range<T> range)
+	{
+		using Limits = std::numeric_limits<T>;
+		std::vector<T> values = { range.max, Limits::max() };
+		if (range.min != Limits::min())
+		{
+			values.push_back((T)(range.min - 1));
+			values.push_back(Limits::min());
+		}
+		return values;
+	}
+
+	template <typename T>
+	void
+	checkFindOutOfRange(const std::vector<T>& data, Range<T> range)
+	{
+		size_t expected = scalarOutOfRange(data, data.size(), range.min, range.max);
+		CHECK(Simd::findOutOfRange(data.data(), data.size(), range.min, range.max) == expected);
+#ifdef BINARYREADER_X86_SIMD
+		if (Simd::hasAVX2())
+		{
+			// Only promises a prefix that passes
+			size_t known = Simd::_findOutOfRangeAVX2(data.data(), data.size(), range.min, range.max);
+			CHECK(known <= expected);
+			CHECK(expected - known < 32 * 4 / sizeof(T) || expected == data.size());
+		}
+#endif
+	}
+
+	template <typename T>
+	void
+	checkFindNotEqual(const std::vector<T>& data, T exact)
+	{
+		size_t expected = scalarNotEqual(data, data.size(), exact);
+		CHECK(Simd::findNotEqual(data.data(), data.size(), exact) == expected);
+#ifdef BINARYREADER_X86_SIMD
+		if (Simd::hasAVX2())
+		{
+			size_t known = Simd::_findNotEqualAVX2(data.data(), data.size(), exact);
+			CHECK(known <= expected);
+			CHECK(expected - known < 32 * 4 / sizeof(T) || expected == data.size());
+		}
+#endif
+	}
+
+	// The Safe read throws for element `failAt` and leaves the cursor just past it
+	template <typename T, bool Big>
+	void
+	checkSafeRead(const std::vector<T>& values, size_t failAt, Range<T> range)
+	{
+		std::vector<uint8_t> bytes(values.size() * sizeof(T));
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			T v = Big ? Simd::byteSwap(values[i]) : values[i];
+			std::memcpy(bytes.data() + i * sizeof(T), &v, sizeof(T));
+		}
+
+		BinaryReaderStaticSlice reader(bytes.data(), bytes.size());
+		std::vector<T> dst(values.size());
+		size_t index = values.size();
+		try
+		{
+			if constexpr (Big)
+				reader.readScalarArrayBESafe(dst.data(), dst.size(), range.min, range.max, "range");
+			else
+				reader.readScalarArraySafe(dst.data(), dst.size(), range.min, range.max, "range");
+		}
+		catch (const LimitException& e)
+		{
+			index = e.index;
+		}
+		CHECK(index == failAt);
+		CHECK(reader.tell() == std::min(failAt + 1, values.size()) * sizeof(T));
+		for (size_t i = 0; i < std::min(failAt + 1, values.size()); i++)
+			CHECK(dst[i] == values[i]);
+	}
+
+	// The data ends a few elements (and half of one) past `failAt`: the bad element is still reported
+	//   ahead of the read error, as element by element. With no bad element the read error comes through
+	template <typename T, class Reader>
+	void
+	checkTruncatedRead(Reader& reader, const std::vector<T>& values, size_t failAt, Range<T> range)
+	{
+		std::vector<T> dst(values.size());
+		size_t index = values.size();
+		bool outOfData = false;
+		try
+		{
+			reader.readScalarArraySafe(dst.data(), dst.size(), range.min, range.max, "range");
+		}
+		catch (const LimitException& e)
+		{
+			index = e.index;
+		}
+		catch (const std::out_of_range&)
+		{
+			outOfData = true;
+		}
+		if (failAt < values.size())
+		{
+			CHECK(index == failAt);
+			CHECK(reader.tell() == (failAt + 1) * sizeof(T));
+		}
+		else
+		{
+			CHECK(outOfData);
+		}
+	}
+
+	template <typename T>
+	void
+	checkTruncated(const std::vector<T>& values, size_t failAt, Range<T> range)
+	{
+		size_t kept = std::min(failAt, values.size() - 4) + 3;
+		std::vector<uint8_t> bytes(kept * sizeof(T) + sizeof(T) / 2);
+		std::memcpy(bytes.data(), values.data(), bytes.size());
+
+		CheckedSlice slice(bytes.data(), bytes.size());
+		checkTruncatedRead(slice, values, failAt, range);
+		Test::StreamReader stream(bytes);
+		checkTruncatedRead(stream, values, failAt, range);
+	}
+
+	template <typename T>
+	void
+	checkType()
+	{
+		std::mt19937_64 rng(sizeof(T) * 2 + std::is_signed_v<T>);
+		for (Range<T> range : ranges<T>())
+		{
+			std::vector<T> passing = passingValues(range, COUNT, rng);
+
+			for (size_t count = 0; count <= COUNT; count++)
+			{
+				std::vector<T> prefix(passing.begin(), passing.begin() + count);
+				checkFindOutOfRange(prefix, range);
+			}
+
+			for (T bad : failingValues(range))
+			{
+				for (size_t at = 0; at < COUNT; at++)
+				{
+					std::vector<T> data = passing;
+					data[at] = bad;
+					checkFindOutOfRange(data, range);
+					// A second failure further on must not hide the first
+					if (at + 7 < COUNT)
+						data[at + 7] = bad;
+					checkFindOutOfRange(data, range);
+					checkSafeRead<T, false>(data, at, range);
+					checkSafeRead<T, true>(data, at, range);
+					if (at % 13 == 0)
+						checkTruncated(data, at, range);
+				}
+			}
+			checkSafeRead<T, false>(passing, COUNT, range);
+			checkTruncated(passing, COUNT, range);
+		}
+
+		// Exact: all equal, then one different value at every position
+		for (T exact : { (T)0, std::numeric_limits<T>::min(), std::numeric_limits<T>::max() })
+		{
+			std::vector<T> data(COUNT, exact);
+			checkFindNotEqual(data, exact);
+			for (size_t at = 0; at < COUNT; at++)
+			{
+				std::vector<T> one = data;
+				one[at] = (T)(exact ^ (T)((T)1 << (at % (sizeof(T) * 8))));
+				checkFindNotEqual(one, exact);
+			}
+		}
+	}
+}
+
+int
+main()
+{
+	checkType<int8_t>();
+	checkType<uint8_t>();
+	checkType<int16_t>();
+	checkType<uint16_t>();
+	checkType<int32_t>();
+	checkType<uint32_t>();
+	checkType<int64_t>();
+	checkType<uint64_t>();
+
+	return Test::finish();
+}
@@ -0,0 +1,257 @@
+// Struct reads with byte-swapped members: the record permutation kernels against a byte-by-byte
+//   permutation, and readStructArray against a member-by-member fixup of each element and per-member reads
+// Strides cover odd chunk counts (the AVX2 kernel doubles those), packed members that cross a
+//   16-byte chunk (no SIMD), and counts below 8 and between whole periods
+
+#include "TestCommon.h"
+
+#include "BinaryReaderStaticSlice.h"
+#include "BinaryReaderStruct.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using namespace BinaryReader;
+
+	constexpr size_t MAX_COUNT = 64;
+	constexpr std::endian BIG = std::endian::big;
+	constexpr std::endian LITTLE = std::endian::little;
+
+	std::vector<uint8_t>
+	randomBytes(size_t size, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<uint8_t> bytes(size);
+		for (uint8_t& b : bytes)
+			b = (uint8_t)rng();
+		return bytes;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// Kernels
+
+	// A permutation like the ones Field::addToPermutation builds: members of 1 to 8 bytes, some reversed
+	std::vector<uint8_t>
+	randomPermutation(size_t stride, std::mt19937& rng)
+	{
+		std::vector<uint8_t> perm(stride);
+		size_t at = 0;
+		while (at < stride)
+		{
+			size_t size = std::min<size_t>((size_t)1 << (rng() % 4), stride - at);
+			bool swapped = rng() % 2 == 0;
+			for (size_t i = 0; i < size; i++)
+				perm[at + i] = (uint8_t)(swapped ? at + size - 1 - i : at + i);
+			at += size;
+		}
+		return perm;
+	}
+
+	void
+	permuteScalar(uint8_t* data, size_t count, size_t stride, const uint8_t* perm)
+	{
+		std::vector<uint8_t> record(stride);
+		for (size_t r = 0; r < count; r++)
+		{
+			uint8_t* item = data + r * stride;
+			for (size_t j = 0; j < stride; j++)
+				record[j] = item[perm[j]];
+			std::memcpy(item, record.data(), stride);
+		}
+	}
+
+	// `kernel` permutes some leading records and returns how many; the scalar permutation finishes the rest
+	template <typename Kernel>
+	void
+	checkKernel(size_t stride, const std::vector<uint8_t>& perm, Kernel&& kernel)
+	{
+		std::vector<uint8_t> source = randomBytes(MAX_COUNT * stride + 64, (uint32_t)stride);
+		for (size_t count = 0; count <= MAX_COUNT; count++)
+		{
+			std::vector<uint8_t> expected = source;
+			permuteScalar(expected.data(), count, stride, perm.data());
+
+			std::vector<uint8_t> data = source;
+			size_t done = kernel(data.data(), count);
+			CHECK(done <= count);
+			permuteScalar(data.data() + done * stride, count - done, stride, perm.data());
+			// Bytes past the records are compared too: the kernels must not write there
+			CHECK(data == expected);
+		}
+	}
+
+	void
+	checkKernels()
+	{
+		std::mt19937 rng(15);
+		for (size_t stride = 1; stride <= 72; stride++)
+		{
+			for (int round = 0; round < 4; round++)
+			{
+				std::vector<uint8_t> perm = randomPermutation(stride, rng);
+				checkKernel(stride, perm, [&](uint8_t* data, size_t count) {
+					return Simd::permuteRecords(data, count, stride, perm.data());
+				});
+#ifdef BINARYREADER_X86_SIMD
+				alignas(16) uint8_t control[Simd::MAX_PERMUTE_CHUNKS][16];
+				size_t chunks = Simd::_permuteControls(stride, perm.data(), control);
+				if (chunks == 0)
+					continue;
+				if (Simd::hasSSSE3())
+				{
+					checkKernel(stride, perm, [&](uint8_t* data, size_t count) {
+						return Simd::_permuteRecordsSSSE3(data, count, stride, control, chunks);
+					});
+				}
+				if (Simd::hasAVX2())
+				{
+					checkKernel(stride, perm, [&](uint8_t* data, size_t count) {
+						return Simd::_permuteRecordsAVX2(data, count, stride, control, chunks);
+					});
+				}
+#endif
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	// Layouts
+
+	struct Header
+	{
+		uint32_t magic;
+		uint16_t version;
+		uint16_t flags;
+		uint64_t tableOffset;
+	};
+
+	using HeaderLayout = StructLayout<Header, Field<&Header::magic, BIG>, Field<&Header::version, BIG>,
+		Field<&Header::tableOffset, BIG>>;
+
+	// 12 bytes: three 16-byte chunks per period
+	struct Vertex
+	{
+		float x;
+		int32_t y;
+		uint16_t index;
+		uint8_t a;
+		uint8_t b;
+	};
+
+	using VertexLayout = StructLayout<Vertex, Field<&Vertex::x, BIG>, Field<&Vertex::y, BIG>, Field<&Vertex::index, BIG>,
+		Field<&Vertex::a, BIG>>;
+
+	enum class Kind : uint16_t
+	{
+	};
+
+	// 40 bytes: five chunks per period, an odd count
+	struct Entry
+	{
+		double weight;
+		int64_t offset;
+		Kind kind;
+		int8_t level;
+		uint32_t crc;
+		uint64_t hash;
+		int16_t delta;
+	};
+
+	using EntryLayout = StructLayout<Entry, Field<&Entry::weight, BIG>, Field<&Entry::offset, BIG>, Field<&Entry::kind, BIG>,
+		Field<&Entry::crc, BIG>, Field<&Entry::hash, LITTLE>, Field<&Entry::delta, BIG>>;
+
+	// Members straddle the 16-byte chunks, so the shuffle can't be used
+#pragma pack(push, 1)
+	struct Packed
+	{
+		uint8_t tag;
+		uint32_t a;
+		uint16_t b;
+		uint64_t c;
+	};
+#pragma pack(pop)
+
+	using PackedLayout = StructLayout<Packed, Field<&Packed::a, BIG>, Field<&Packed::b, BIG>, Field<&Packed::c, BIG>>;
+
+	// No probe object, so always member by member
+	struct NoDefault
+	{
+		uint32_t id;
+		uint16_t size;
+		uint16_t pad;
+
+		NoDefault(uint32_t id)
+			: id(id), size(0), pad(0)
+		{
+		}
+	};
+
+	using NoDefaultLayout = StructLayout<NoDefault, Field<&NoDefault::id, BIG>, Field<&NoDefault::size, BIG>>;
+
+	// readStructArray against a fixup of one element at a time, which swaps each member on its own
+	template <class Layout>
+	void
+	checkLayout()
+	{
+		using S = typename Layout::Type;
+		std::vector<uint8_t> bytes = randomBytes(MAX_COUNT * sizeof(S), (uint32_t)sizeof(S) + 1000);
+
+		for (size_t count = 1; count <= MAX_COUNT; count++)
+		{
+			std::vector<uint8_t> expected(bytes.begin(), bytes.begin() + count * sizeof(S));
+			for (size_t i = 0; i < count; i++)
+				Layout::fixup((S*)expected.data() + i, 1);
+
+			BinaryReaderStaticSlice slice(bytes.data(), bytes.size());
+			std::vector<uint8_t> got(count * sizeof(S));
+			slice.readStructArray<Layout>((S*)got.data(), count);
+			CHECK(got == expected);
+			CHECK(slice.tell() == count * sizeof(S));
+
+			Test::StreamReader stream(bytes);
+			std::vector<uint8_t> fromStream(count * sizeof(S));
+			stream.readStructArray<Layout>((S*)fromStream.data(), count);
+			CHECK(fromStream == expected);
+		}
+	}
+
+	// Independent of Field: each member read on its own with readScalar or readScalarBE
+	void
+	checkHeaderMembers()
+	{
+		std::vector<uint8_t> bytes = randomBytes(MAX_COUNT * sizeof(Header), 1);
+		BinaryReaderStaticSlice slice(bytes.data(), bytes.size());
+		std::vector<Header> headers(MAX_COUNT);
+		slice.readStructArray<HeaderLayout>(headers.data(), headers.size());
+
+		BinaryReaderStaticSlice members(bytes.data(), bytes.size());
+		for (const Header& header : headers)
+		{
+			CHECK(header.magic == members.readScalarBE<uint32_t>());
+			CHECK(header.version == members.readScalarBE<uint16_t>());
+			CHECK(header.flags == members.readScalar<uint16_t>());
+			CHECK(header.tableOffset == members.readScalarBE<uint64_t>());
+		}
+	}
+}
+
+int
+main()
+{
+	checkKernels();
+
+	checkLayout<HeaderLayout>();
+	checkLayout<VertexLayout>();
+	checkLayout<EntryLayout>();
+	checkLayout<PackedLayout>();
+	checkLayout<NoDefaultLayout>();
+	checkHeaderMembers();
+
+	return Test::finish();
+}